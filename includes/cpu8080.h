@@ -3,6 +3,31 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "i8080.h"
+#include "memory.h"
+#include "io.h"
+#include "sched.h"
+
+#define CPU_CLOCK I8080_CLOCK // Hz, fréquence du 8080 de la borne
+
+// Cycles depuis la mise sous tension et prochaines interrupts, à sauvegarder avec les registres
+typedef struct Cpu_Clock
+{
+    uint64_t totcyc;
+    Scheduler sched;
+} Cpu_Clock;
+
+// Appels vers l'hôte, tous facultatifs : sans eux la machine tourne seule
+typedef struct Machine_Hooks
+{
+    I8080_Frame_Fn frame;
+    I8080_Sound_Fn sound;
+    I8080_Out_Fn out;
+    void *frame_user;
+    void *sound_user;
+    void *out_user;
+} Machine_Hooks;
 
 typedef struct CPU
 {
@@ -23,23 +48,41 @@ typedef struct CPU
     bool p;
     bool s;
 
-    uint8_t memory[0xFFFF];
-
     bool halted;
     bool interrupt_enable; // Interrupt OK si true et interrupt_pending true
     bool interrupt_pending; // Un périphérique demande une interrupt
     bool ei_pending; // Dans ei pour signifier qu'après on pourra executer une interrupt
     uint8_t interrupt_vector; // Variable contenant l'opcode que l'on veut executer pendant L'interrupt souvetn RST 
+
+    // Le reste de la machine : tout est dans la structure, rien de global
+    Cpu_Clock clock;
+    Io_State io;
+    bool flat_memory; // ROM de test : 64 Ko de RAM à plat, sans la carte de la borne
+    uint64_t rom_hash; // FNV-1a de la ROM, calculé au chargement
+    Machine_Hooks hooks;
+    uint8_t memory[0x10000]; // ROM 0x0000-0x1FFF, RAM 0x2000-0x23FF, VRAM 0x2400-0x3FFF
 } CPU;
 
-int get_cyc();
+// Les registres se copient d'un bloc, tout ce qui précède clock
+#define CPU_REGS_SIZE offsetof(CPU, clock)
+
+typedef enum
+{
+    EMU_STEP,      // Une instruction, rien d'autre
+    EMU_MID_FRAME, // Milieu de l'écran (RST 1)
+    EMU_END_FRAME, // Fin de frame, VBlank (RST 2)
+} Emu_Event;
+
+uint64_t get_cyc(const CPU *cpu);
 
 void init_cpu(CPU *cpu);
+void reset_cpu(CPU *cpu);
 void check_condition_bits(CPU *cpu, bool z, bool c, bool p, bool s, uint16_t data);
-uint8_t get_f_flags(CPU *cpu);
+uint8_t get_f_flags(const CPU *cpu);
 
 int execute(CPU *cpu, uint8_t opcode);
-void step_emu(CPU *cpu);
+Emu_Event step_emu(CPU *cpu);
+Emu_Event run_emu(CPU *cpu);
 
 void ask_interrupt(CPU *cpu, uint8_t opcode);
 
@@ -0,0 +1,22 @@
+#ifndef FILTER__H
+#define FILTER__H
+
+#include <stdint.h>
+
+typedef enum
+{
+    FILTER_NONE,
+    FILTER_NEAREST,   // Agrandissement entier, pixels dupliqués
+    FILTER_SCALE2X,
+    FILTER_SCALE3X,
+    FILTER_SCANLINES, // Nearest + une ligne sur scale assombrie
+    FILTER_CRT,       // Scanlines + masque de phosphores R/G/B
+} Filter_Kind;
+
+int parse_filter(const char *name, Filter_Kind *out);
+int init_filter(Filter_Kind k, int s, int nb_threads);
+Filter_Kind get_filter();
+int get_filter_scale();
+void apply_filter(const uint32_t *src, uint32_t *dst, int dst_pitch);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef FORKSERV__H
+#define FORKSERV__H
+
+#include "i8080.h"
+
+#define FORK_MAX_CHILDREN 256 // Enfants vivants en même temps
+#define FORK_MAX_REQUEST 4096
+#define FORK_MAX_INPUTS 256   // Entrées d'un script, répétées en boucle
+
+int run_fork_server(I8080_Machine *m, const char *path);
+int run_fork_client(const char *path, const char *request, int count);
+
+#endif
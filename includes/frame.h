@@ -0,0 +1,43 @@
+#ifndef FRAME__H
+#define FRAME__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Une image terminée, telle que produite par step_emu()
+typedef struct Frame
+{
+    const uint8_t *vram; // VRAM_SIZE octets, 1 bit par pixel, non tournée
+    uint32_t number;     // Numéro de la frame depuis le démarrage
+    uint64_t cyc;        // get_cyc() au moment de la frame
+    uint64_t hash;       // hash_vram() de la VRAM
+    bool changed;        // Le hash diffère de celui de la frame précédente
+} Frame;
+
+typedef struct Video_Backend
+{
+    const char *name;
+    bool has_window;                     // Fournit aussi les événements clavier SDL
+    int (*init)();
+    void (*present)(const Frame *frame);
+    void (*quit)();
+} Video_Backend;
+
+typedef void (*Frame_Consumer)(const Frame *frame, void *user);
+
+int init_video(const char *backend);
+const Video_Backend *get_video_backend();
+void quit_video();
+int add_frame_consumer(Frame_Consumer consumer, void *user);
+void remove_frame_consumer(Frame_Consumer consumer, void *user);
+void submit_frame(const uint8_t *vram, uint64_t cyc);
+uint32_t get_frame_number();
+void set_present_skip(bool skip);
+bool is_present_skipped();
+void set_frame_output(bool present, bool consume);
+void get_frame_output(bool *present, bool *consume);
+void present_frame(const uint8_t *vram, uint64_t cyc);
+void frame_to_argb(const Frame *frame, uint32_t *frameBuffer);
+const uint8_t *get_offscreen_vram();
+
+#endif
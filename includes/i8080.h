@@ -0,0 +1,63 @@
+#ifndef I8080__H
+#define I8080__H
+
+/*
+libi8080 : le cœur de l'émulateur (8080, carte mémoire et entrées/sorties de
+la borne Space Invaders) en bibliothèque statique, sans SDL. Chaque machine
+est indépendante : plusieurs peuvent tourner côte à côte, une par thread au
+besoin. Cette interface ne change qu'en incrémentant I8080_API_VERSION.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define I8080_API_VERSION 1
+
+#define I8080_CLOCK 1996800  // Hz
+#define I8080_VRAM_SIZE 0x1C00
+#define I8080_FRAME_W 256    // VRAM non tournée, 1 bit par pixel, 32 octets par ligne
+#define I8080_FRAME_H 224
+
+// Bits de i8080_set_inputs(), port 1
+#define I8080_COIN      0x01
+#define I8080_P2_START  0x02
+#define I8080_P1_START  0x04
+#define I8080_P1_SHOT   0x10
+#define I8080_P1_LEFT   0x20
+#define I8080_P1_RIGHT  0x40
+// Port 2
+#define I8080_P2_SHOT   0x10
+#define I8080_P2_LEFT   0x20
+#define I8080_P2_RIGHT  0x40
+
+typedef struct CPU I8080_Machine;
+
+// VBlank : la VRAM de la frame terminée, et le cycle où elle l'a été
+typedef void (*I8080_Frame_Fn)(void *user, const uint8_t *vram, uint64_t cyc);
+// Écriture qui change un port de son (3 ou 5), horodatée en cycles
+typedef void (*I8080_Sound_Fn)(void *user, uint8_t port, uint8_t value, uint64_t cyc);
+// Écriture sur un port que la borne n'utilise pas (ROM de test)
+typedef void (*I8080_Out_Fn)(void *user, uint8_t port, uint8_t value);
+
+int i8080_api_version();
+I8080_Machine *i8080_create();
+void i8080_destroy(I8080_Machine *m);
+int i8080_load_rom(I8080_Machine *m, const char *path);
+int i8080_load_rom_data(I8080_Machine *m, const uint8_t *data, size_t size);
+void i8080_reset(I8080_Machine *m);
+void i8080_set_inputs(I8080_Machine *m, uint8_t port1, uint8_t port2);
+void i8080_run_frame(I8080_Machine *m);
+const uint8_t *i8080_get_frame(const I8080_Machine *m);
+uint64_t i8080_frame_hash(const I8080_Machine *m);
+uint64_t i8080_state_hash(const I8080_Machine *m);
+uint64_t i8080_get_cycles(const I8080_Machine *m);
+uint8_t i8080_peek(const I8080_Machine *m, uint16_t addr);
+size_t i8080_state_size();
+int i8080_save_state(const I8080_Machine *m, void *buf, size_t size);
+int i8080_load_state(I8080_Machine *m, const void *buf, size_t size);
+void i8080_set_frame_callback(I8080_Machine *m, I8080_Frame_Fn fn, void *user);
+void i8080_set_sound_callback(I8080_Machine *m, I8080_Sound_Fn fn, void *user);
+void i8080_set_out_callback(I8080_Machine *m, I8080_Out_Fn fn, void *user);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef INPUT__H
+#define INPUT__H
+
+#include <stdint.h>
+#include "cpu8080.h"
+#include "io.h"
+
+void keyboard_to_io(IO_Def iod, uint8_t value);
+void set_input_bot(uint32_t seed);
+void latch_inputs(CPU *cpu);
+void set_remote_inputs(const uint8_t ports[2]);
+void get_pending_inputs(uint8_t ports[2]);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef INVADERS__H
+#define INVADERS__H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i8080.h"
+
+// Variables du jeu en RAM (ROM Midway d'origine)
+#define RAM_SCORE_L   0x20F8 // Score du joueur 1, BCD : 0x20F9 0x20F8 = 4 chiffres
+#define RAM_SCORE_M   0x20F9
+#define RAM_GAME_MODE 0x20EF // 1 pendant une partie, 0 en démo
+#define RAM_SHIPS     0x21FF // Vaisseaux en réserve du joueur 1
+
+uint32_t invaders_score(const I8080_Machine *m);
+uint8_t invaders_ships(const I8080_Machine *m);
+bool invaders_playing(const I8080_Machine *m);
+int invaders_start_game(I8080_Machine *m);
+
+#endif
@@ -5,6 +5,15 @@
 
 typedef struct CPU CPU;
 
+// Registres de la borne : les entrées en attente côté hôte n'en font pas partie
+typedef struct Io_State
+{
+    uint16_t bits_reg;
+    uint8_t shift_amount;
+    uint8_t latched[2];
+    uint8_t sound[2]; // Derniers octets écrits sur les ports 3 et 5
+} Io_State;
+
 typedef enum
 {
     COIN,
@@ -19,8 +28,9 @@ typedef enum
     TWO_P_RIGHT,
 } IO_Def;
 
-void write_io(CPU cpu, uint8_t port, uint8_t value);
-uint8_t read_io(uint8_t port);
-void keyboard_to_io(IO_Def iod, uint8_t value);
+void write_io(CPU *cpu, uint8_t port, uint8_t value);
+uint8_t read_io(CPU *cpu, uint8_t port);
+void set_inputs(CPU *cpu, uint8_t port1, uint8_t port2);
+void get_io_mask(IO_Def iod, uint8_t mask[2]);
 
 #endif
\ No newline at end of file
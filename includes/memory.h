@@ -2,13 +2,21 @@
 #define MEMORY__H
 
 #define MEMORY_SIZE 0x2000
+#define RAM_START 0x2000
+#define RAM_SIZE 0x400
+#define VRAM_START 0x2400
+#define VRAM_SIZE 0x1C00
 
 #include <stdint.h>
+#include <stddef.h>
 
 typedef struct CPU CPU;
 
 int load_rom(CPU *cpu, const char path[]);
-uint8_t read_memory(CPU *cpu, uint16_t addr);
-void write_memory(uint16_t addr, uint8_t value);
+int load_rom_data(CPU *cpu, const uint8_t *data, size_t size);
+uint8_t read_memory(const CPU *cpu, uint16_t addr);
+void write_memory(CPU *cpu, uint16_t addr, uint8_t value);
+const uint8_t *get_vram(const CPU *cpu);
+uint64_t hash_vram(const uint8_t *vram);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,24 @@
+#ifndef MOVIE__H
+#define MOVIE__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MOVIE_VERSION 1
+
+typedef struct Movie_Stats
+{
+    uint32_t latches;  // Points de lecture des entrées enregistrés ou rejoués
+    uint32_t runs;     // Suites d'entrées identiques (une par changement)
+    uint32_t bytes;    // Taille du fichier
+    bool finished;     // Rejeu : toutes les entrées ont été consommées
+} Movie_Stats;
+
+int start_movie_record(const char *path, bool per_interrupt);
+int start_movie_play(const char *path, bool *per_interrupt);
+void movie_latch(uint8_t ports[2]);
+bool movie_finished();
+void stop_movie();
+void get_movie_stats(Movie_Stats *play, Movie_Stats *record);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef NETPLAY__H
+#define NETPLAY__H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cpu8080.h"
+
+#define NET_DEFAULT_PORT 7080
+#define NET_DEFAULT_DELAY 2 // Frames entre la lecture d'une touche et la frame qui la voit
+#define NET_MAX_DELAY 8
+#define NET_MAX_ROLLBACK 8  // Frames jouées au plus sur une entrée prédite
+
+typedef struct Net_Stats
+{
+    uint32_t frames;       // Frames avancées en netplay
+    uint32_t rollbacks;    // Prédictions fausses corrigées
+    uint32_t depth_max;    // Frames rejouées par un rollback
+    double depth_avg;
+    uint32_t resimulated;  // Frames rejouées au total
+    double resim_avg_us;   // Coût d'une frame rejouée
+    double resim_max_us;   // Coût du plus long rollback
+    uint32_t stalls;       // Frames retenues pour ne pas prendre d'avance sur l'autre
+    uint32_t waits;        // Fenêtre de prédiction pleine : attente des entrées de l'autre
+    uint32_t sent;
+    uint32_t received;
+    uint32_t dropped;      // Paquets jetés par le simulateur de pertes
+    uint32_t checks;       // Comparaisons de l'état des deux machines
+    uint32_t desyncs;
+} Net_Stats;
+
+int init_netplay(const char *join, int port, int delay);
+void set_net_shim(int latency_ms, int loss_pct);
+bool netplay_active();
+bool netplay_frame(CPU *cpu);
+void netplay_finish(CPU *cpu);
+uint32_t get_net_frame();
+void quit_netplay();
+void get_net_stats(Net_Stats *stats);
+
+#endif
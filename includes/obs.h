@@ -0,0 +1,19 @@
+#ifndef OBS__H
+#define OBS__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Observations pour les agents, calculées directement depuis la VRAM.
+// Image droite (OBS_W x OBS_H, comme à l'écran), buffers fournis par l'appelant.
+// Sans SDL : fait partie de libi8080.
+#define OBS_W 224
+#define OBS_H 256
+#define OBS_PACKED_SIZE (OBS_W * OBS_H / 8)
+#define OBS_GRAY_SIZE (OBS_W * OBS_H)
+
+void obs_packed(const uint8_t *vram, uint8_t *out);
+void obs_gray(const uint8_t *vram, uint8_t *out);
+int obs_pooled(const uint8_t *vram, uint8_t *out, int ow, int oh);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef OVERLAY__H
+#define OVERLAY__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bande de lignes écran [first, last] teintée par une couleur ARGB
+typedef struct Overlay_Band
+{
+    int first;
+    int last;
+    uint32_t color;
+} Overlay_Band;
+
+int load_overlay(const char *profile);
+const uint32_t *get_overlay_rows();
+int get_overlay_bands(const Overlay_Band **bands);
+bool overlay_is_mono();
+
+#endif
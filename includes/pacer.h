@@ -0,0 +1,51 @@
+#ifndef PACER__H
+#define PACER__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PACER_DEFAULT_HZ 59.94
+#define PACER_MAX_SKIP 4 // Frames consécutives sans affichage au maximum
+#define PACER_TURBO_EVERY 8 // Turbo : une frame affichée sur N par défaut
+#define PACER_TURBO_MAX 240
+
+typedef enum
+{
+    PACING_OFF,   // Aussi vite que possible (headless)
+    PACING_VSYNC, // La vsync du renderer rythme l'émulation, le pacer ne fait que mesurer
+    PACING_TIMER, // Horloge haute résolution, vsync coupée
+    PACING_AUDIO, // La carte son rythme l'émulation, en consommant la file audio
+} Pacing_Mode;
+
+typedef struct Pacer_Stats
+{
+    uint32_t frames;
+    uint32_t presented;
+    uint32_t skipped;   // Frames émulées sans être affichées
+    uint32_t late;      // Frames terminées après leur échéance
+    double cost_min_us; // Travail hôte d'une frame (émulation + affichage)
+    double cost_avg_us;
+    double cost_max_us;
+    double fps;         // Frames émulées par seconde réelle
+} Pacer_Stats;
+
+// Vitesse mesurée sur la dernière fenêtre d'environ une demi-seconde
+typedef struct Pacer_Speed
+{
+    double fps;    // Frames émulées par seconde réelle
+    double mhz;    // Cycles émulés par seconde réelle, en MHz
+    double factor; // Par rapport à la borne (CPU_CLOCK), négatif en rewind
+} Pacer_Speed;
+
+int parse_pacing(const char *name, Pacing_Mode *out);
+void init_pacer(Pacing_Mode mode, double hz, uint64_t cyc);
+Pacing_Mode get_pacing();
+void pacer_end_frame(uint64_t cyc);
+void pacer_stall();
+void get_pacer_stats(Pacer_Stats *stats);
+int set_turbo_every(int n);
+void set_turbo(bool on);
+bool get_turbo();
+bool get_pacer_speed(Pacer_Speed *speed);
+
+#endif
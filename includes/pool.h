@@ -0,0 +1,14 @@
+#ifndef POOL__H
+#define POOL__H
+
+#define MAX_WORKERS 32
+
+// Une tâche = un indice dans [0, nb_tasks), user est partagé par toutes les tâches
+typedef void (*Pool_Job)(void *user, int task);
+
+int init_pool(int nb_threads);
+int get_pool_size();
+void pool_run(Pool_Job job, void *user, int nb_tasks);
+void quit_pool();
+
+#endif
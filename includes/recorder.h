@@ -0,0 +1,34 @@
+#ifndef RECORDER__H
+#define RECORDER__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum
+{
+    REC_Y4M, // Vidéo YUV4MPEG2 monochrome, lisible par ffmpeg
+    REC_RAW, // VRAM brute 1bpp (VRAM_SIZE octets par frame, non tournée)
+    REC_PNG, // Une image PNG 1 bit par frame : <path>_000001.png
+} Rec_Format;
+
+typedef enum
+{
+    REC_DROP,  // File pleine : la frame est perdue, l'émulation ne ralentit jamais
+    REC_BLOCK, // File pleine : l'émulation attend le thread d'écriture
+} Rec_Policy;
+
+typedef struct Recorder_Stats
+{
+    uint32_t depth;     // Frames en attente dans la file
+    uint32_t max_depth;
+    uint32_t written;
+    uint32_t dropped;
+    uint32_t skipped;   // Frames identiques à la précédente (dedup)
+} Recorder_Stats;
+
+int parse_rec_format(const char *name, Rec_Format *out);
+int start_recorder(const char *path, Rec_Format format, Rec_Policy policy, int queue_frames, bool dedup);
+void stop_recorder();
+void get_recorder_stats(Recorder_Stats *stats);
+
+#endif
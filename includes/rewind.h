@@ -0,0 +1,26 @@
+#ifndef REWIND__H
+#define REWIND__H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cpu8080.h"
+
+#define REWIND_KEYFRAME 120 // Une image complète toutes les 2 secondes
+
+typedef struct Rewind_Stats
+{
+    uint32_t frames;        // Frames disponibles pour revenir en arrière
+    uint32_t bytes;         // Octets occupés dans le tampon
+    uint32_t capacity;      // Taille du tampon
+    double delta_avg;       // Taille moyenne d'un delta, en octets
+    double capture_avg_us;  // Coût moyen d'une capture
+} Rewind_Stats;
+
+int init_rewind(int seconds);
+void quit_rewind();
+bool rewind_enabled();
+void rewind_capture(const CPU *cpu);
+bool rewind_step(CPU *cpu);
+void get_rewind_stats(Rewind_Stats *stats);
+
+#endif
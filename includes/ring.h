@@ -0,0 +1,26 @@
+#ifndef RING__H
+#define RING__H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <../includes/SDL3/SDL.h>
+
+// File circulaire sans verrou, un seul producteur et un seul consommateur
+typedef struct Ring
+{
+    uint8_t *buf;
+    uint32_t size;      // Puissance de 2
+    SDL_AtomicU32 head; // Total écrit, modifié uniquement par le producteur
+    SDL_AtomicU32 tail; // Total lu, modifié uniquement par le consommateur
+} Ring;
+
+int init_ring(Ring *ring, uint32_t min_size);
+void free_ring(Ring *ring);
+uint32_t ring_used(Ring *ring);
+uint32_t ring_free(Ring *ring);
+bool ring_push(Ring *ring, const void *data, uint32_t len);
+uint32_t ring_write(Ring *ring, const void *data, uint32_t len);
+bool ring_pop(Ring *ring, void *out, uint32_t len);
+uint32_t ring_read(Ring *ring, void *out, uint32_t len);
+
+#endif
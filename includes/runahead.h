@@ -0,0 +1,12 @@
+#ifndef RUNAHEAD__H
+#define RUNAHEAD__H
+
+#include "cpu8080.h"
+
+#define RUNAHEAD_MAX 8
+
+int init_runahead(int frames);
+int get_runahead();
+void run_ahead(CPU *cpu);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef SCHED__H
+#define SCHED__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHED_MAX 4               // Échéances en attente au plus (copiées à chaque rewind)
+#define FRAME_CYCLES 33333        // Une frame de la borne, 1/60 s
+#define MID_SCREEN_CYCLES 16667   // Le faisceau au milieu de l'écran, depuis le VBlank
+
+// Les périphériques minutés de la machine, une échéance en attente chacun
+typedef enum
+{
+    SCHED_MID_SCREEN, // RST 1
+    SCHED_VBLANK,     // RST 2, fin de frame
+    SCHED_COUNT,
+} Sched_Id;
+
+typedef struct Sched_Event
+{
+    uint64_t at;  // Cycle absolu (get_cyc)
+    uint32_t id;  // Sched_Id
+} Sched_Event;
+
+// Tas binaire d'échéances, la plus proche en tête. Copié tel quel avec
+// l'horloge dans les sauvegardes : pas de pointeur
+typedef struct Scheduler
+{
+    uint64_t next;  // Échéance de la tête, UINT64_MAX si rien n'est prévu
+    uint32_t count;
+    Sched_Event heap[SCHED_MAX];
+} Scheduler;
+
+void sched_clear(Scheduler *s);
+int sched_add(Scheduler *s, Sched_Id id, uint64_t at);
+bool sched_pop(Scheduler *s, Sched_Event *out);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SESSION__H
+#define SESSION__H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i8080.h"
+
+#define SESSION_VERSION 1
+#define SESSION_DEFAULT_INTERVAL 600 // Frames entre deux checkpoints (10 s)
+
+typedef struct Session_Stats
+{
+    uint32_t frames;       // Latches enregistrés, ou rejoués
+    uint32_t checkpoints;  // Écrits, ou vérifiés au rejeu
+    uint32_t mismatches;   // Checkpoints dont l'état rejoué diffère
+    uint32_t first_mismatch;
+    uint64_t bytes;
+    uint32_t seek_from;    // Checkpoint de départ du dernier seek
+    uint32_t seek_frames;  // Frames émulées ensuite pour arriver à la cible
+    double seek_ms;
+} Session_Stats;
+
+int start_session_record(const char *path, int interval);
+void session_latch(const I8080_Machine *m, uint8_t port1, uint8_t port2);
+void stop_session_record();
+int open_session(const char *path);
+uint32_t get_session_frames();
+int session_seek(I8080_Machine *m, uint32_t frame, bool verify);
+void close_session();
+void get_session_stats(Session_Stats *rec, Session_Stats *play);
+
+#endif
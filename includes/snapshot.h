@@ -0,0 +1,47 @@
+#ifndef SNAPSHOT__H
+#define SNAPSHOT__H
+
+#include <stdint.h>
+#include "cpu8080.h"
+#include "memory.h"
+#include "io.h"
+
+#define STATE_VERSION 3 // À incrémenter dès que la disposition de Snapshot change
+
+// État complet de la machine, hors ROM : quelques copies mémoire (~8 Ko)
+// Disposition plate, copiée telle quelle en mémoire comme dans les fichiers
+typedef struct Snapshot
+{
+    uint8_t regs[CPU_REGS_SIZE];
+    Cpu_Clock clock;
+    uint8_t ram[RAM_SIZE];
+    uint8_t vram[VRAM_SIZE];
+    Io_State io; // Avec les derniers octets envoyés au son
+} Snapshot;
+
+// En-tête des sauvegardes : refusées si la version, la taille ou la ROM diffèrent
+typedef struct State_Header
+{
+    char magic[4];        // "SIST"
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t state_size;  // sizeof(Snapshot)
+    uint32_t reserved;
+    uint64_t rom_hash;
+} State_Header;
+
+typedef struct Save_State
+{
+    State_Header header;
+    Snapshot snap;
+} Save_State;
+
+uint64_t rom_hash(const CPU *cpu);
+void save_snapshot(const CPU *cpu, Snapshot *snap);
+void load_snapshot(CPU *cpu, const Snapshot *snap);
+void save_state(const CPU *cpu, Save_State *state);
+int load_state(CPU *cpu, const Save_State *state);
+int save_state_file(const CPU *cpu, const char *path);
+int load_state_file(CPU *cpu, const char *path);
+
+#endif
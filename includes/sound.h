@@ -0,0 +1,63 @@
+#ifndef SOUND__H
+#define SOUND__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SOUND_RATE 48000
+#define SOUND_DEFAULT_LATENCY 40 // ms visés dans la file audio
+#define SOUND_MAX_DRIFT 0.005    // Correction de ratio maximale (±0,5 %)
+
+// Dans l'ordre des échantillons standard : <dossier>/0.wav ... 9.wav
+typedef enum
+{
+    SND_UFO,         // Port 3 bit 0, joué en boucle tant que le bit est à 1
+    SND_SHOT,        // Port 3 bit 1
+    SND_PLAYER_DIE,  // Port 3 bit 2
+    SND_INVADER_DIE, // Port 3 bit 3
+    SND_FLEET_1,     // Port 5 bits 0 à 3 : les 4 notes de la flotte
+    SND_FLEET_2,
+    SND_FLEET_3,
+    SND_FLEET_4,
+    SND_UFO_HIT,     // Port 5 bit 4
+    SND_EXTRA_LIFE,  // Port 3 bit 4
+    NB_SOUNDS,
+} Sound_Id;
+
+typedef enum
+{
+    SOUND_SYNTH,   // Circuits discrets synthétisés (synth.c)
+    SOUND_SAMPLES, // Échantillons WAV
+} Sound_Engine;
+
+typedef struct Sound_Stats
+{
+    uint32_t events;    // Changements de bits capturés sur les ports 3 et 5
+    uint32_t underruns; // Le callback audio a trouvé la file vide
+    uint32_t overruns;  // Échantillons perdus, file pleine
+    uint32_t queued;    // Échantillons en attente dans la file
+    uint32_t target;    // Remplissage visé, en échantillons
+    uint32_t fill_min;  // Remplissage relevé à chaque fin de frame
+    uint32_t fill_max;
+    double fill_avg;
+    double latency_ms;  // File + tampon de SDL, au dernier relevé
+    double ratio;       // Ratio de ré-échantillonnage courant
+    double ratio_min;
+    double ratio_max;
+} Sound_Stats;
+
+int parse_sound_engine(const char *name, Sound_Engine *out);
+int init_sound(Sound_Engine engine, const char *samples_dir, bool output, int latency_ms);
+bool sound_is_output();
+uint32_t get_sound_queued();
+uint32_t get_sound_target();
+void quit_sound();
+int start_sound_capture(const char *path, uint64_t cyc);
+void stop_sound_capture();
+void sound_write(uint8_t port, uint8_t value, uint64_t cyc);
+void sound_end_frame(uint64_t cyc);
+void sound_seek(uint64_t cyc, const uint8_t ports[2]);
+void set_sound_muted(bool mute);
+void get_sound_stats(Sound_Stats *stats);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef STREAM__H
+#define STREAM__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STREAM_VERSION 1
+#define STREAM_SLOTS 16       // Frames gardées dans l'anneau partagé
+#define STREAM_KEYFRAME 60    // Une image complète par seconde en mode delta
+#define STREAM_MAX_VIEWERS 8
+
+typedef enum
+{
+    STREAM_RAW,   // VRAM brute à chaque frame
+    STREAM_DELTA, // Octets modifiés depuis la frame précédente
+} Stream_Format;
+
+typedef struct Stream_Info
+{
+    uint32_t number;   // Numéro de la frame chez l'émulateur
+    uint64_t cyc;
+    uint64_t hash;     // hash_vram() côté émulateur
+} Stream_Info;
+
+typedef struct Stream_Stats
+{
+    uint32_t frames;     // Publiées, ou reçues par le viewer
+    uint32_t unchanged;  // Serveur : frames identiques à la précédente, non publiées
+    uint32_t keyframes;
+    uint64_t bytes;      // Données de frame écrites (ou lues) dans l'anneau
+    uint32_t viewers;    // Connexions acceptées depuis le début
+    uint32_t inputs;     // Lignes INPUT reçues
+    uint32_t lost;       // Viewer : frames écrasées avant d'être lues
+    uint32_t bad_hash;   // Viewer : frames reconstruites dont le hash diffère
+} Stream_Stats;
+
+int parse_stream_format(const char *name, Stream_Format *out);
+int start_stream_server(const char *path, Stream_Format format);
+void stream_frame(const uint8_t *vram, uint32_t number, uint64_t cyc, uint64_t hash, bool changed);
+bool stream_poll(uint8_t ports[2]);
+void stop_stream_server();
+
+int stream_attach(const char *path);
+int stream_next_frame(uint8_t *vram, Stream_Info *info);
+int stream_send_inputs(uint8_t port1, uint8_t port2);
+void stream_detach();
+
+void get_stream_stats(Stream_Stats *server, Stream_Stats *viewer);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef SYNTH__H
+#define SYNTH__H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sound.h"
+
+void init_synth(int rate);
+void synth_gate(Sound_Id id, bool on);
+bool synth_held(Sound_Id id);
+void synth_render(int16_t *out, uint32_t n);
+
+#endif
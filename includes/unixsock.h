@@ -0,0 +1,16 @@
+#ifndef UNIXSOCK__H
+#define UNIXSOCK__H
+
+// Sockets Unix locales du fork server et du stream de frames (POSIX seulement)
+#ifndef _WIN32
+
+# include <sys/socket.h>
+# include <sys/un.h>
+
+int unix_address(const char *path, struct sockaddr_un *addr);
+int read_line(int fd, char *buf, int size);
+void write_all(int fd, const char *s);
+
+#endif
+
+#endif
@@ -5,4 +5,11 @@
 
 char *opcode_name(uint8_t opcode);
 
+// Entiers petit-boutistes des formats de fichier et des paquets
+void put_le16(uint8_t *p, uint16_t v);
+void put_le32(uint8_t *p, uint32_t v);
+void put_le64(uint8_t *p, uint64_t v);
+uint32_t get_le32(const uint8_t *p);
+uint64_t get_le64(const uint8_t *p);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef VECENV__H
+#define VECENV__H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i8080.h"
+
+#define VECENV_MAX 4096
+#define VECENV_MAX_SKIP 16
+#define VECENV_POOL_W 84 // Observation réduite par max-pooling
+#define VECENV_POOL_H 84
+
+// Forme des observations (obs.c), la taille par env en découle
+typedef enum
+{
+    VEC_OBS_RAW,    // VRAM brute tournée, 1 bit par pixel
+    VEC_OBS_PACKED, // Image droite 1 bit par pixel
+    VEC_OBS_GRAY,   // Image droite, un octet 0/255 par pixel
+    VEC_OBS_POOLED, // VECENV_POOL_W x VECENV_POOL_H, un octet 0/255 par pixel
+} Vec_Obs;
+
+// Actions du joueur 1, tenues pendant les frame_skip frames d'un pas
+typedef enum
+{
+    ACT_NOOP,
+    ACT_LEFT,
+    ACT_RIGHT,
+    ACT_FIRE,
+    ACT_LEFT_FIRE,
+    ACT_RIGHT_FIRE,
+    NB_ACTIONS,
+} Vec_Action;
+
+// Structure de tableaux : env i occupe l'indice i de chaque tableau
+typedef struct Vec_Env
+{
+    int nb_envs;
+    int frame_skip;
+    Vec_Obs obs_mode;
+    size_t obs_size;     // Octets d'observation par env
+    uint8_t *obs;        // nb_envs * obs_size
+    int32_t *rewards;    // Points gagnés pendant le pas
+    uint8_t *dones;      // 1 : partie finie, l'env est reparti d'une nouvelle partie
+    uint32_t *scores;    // Score de la partie en cours (ou finie, si done)
+    uint8_t *lives;      // Vaisseaux en réserve
+    uint32_t *episode_frames;
+
+    I8080_Machine **machines;
+    const uint8_t *actions; // Le temps d'un vec_env_step
+    uint8_t *start_state;   // Début de partie, commun à tous les env
+    size_t state_size;
+    uint32_t episodes;      // Parties terminées depuis la création
+} Vec_Env;
+
+int parse_vec_obs(const char *name, Vec_Obs *out);
+size_t vec_obs_size(Vec_Obs mode);
+Vec_Env *create_vec_env(const char *rom, int nb_envs, int frame_skip, Vec_Obs obs_mode, int nb_threads);
+void vec_env_reset(Vec_Env *env);
+void vec_env_step(Vec_Env *env, const uint8_t *actions);
+void destroy_vec_env(Vec_Env *env);
+
+#endif
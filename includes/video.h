@@ -3,12 +3,31 @@
 
 #define W 224
 #define H 256
+// Orientation de la VRAM avant la rotation de l'écran
+#define NATIVE_W 256
+#define NATIVE_H 224
+#define WINDOW_TITLE "Intel8080 - SpaceInvader"
 
 #include <../includes/SDL3/SDL.h>
+#include "frame.h"
+
+typedef enum
+{
+    UPLOAD_ARGB,   // Expansion CPU en ARGB8888 (toujours disponible)
+    UPLOAD_INDEX8, // Texture 8bpp indexée, rotation par le GPU
+    UPLOAD_INDEX1, // VRAM envoyée telle quelle en 1bpp, rotation par le GPU
+} Upload_Mode;
 
 void print_version_sdl3();
+void fill_frame_buffer(const uint8_t *vram, uint32_t *frameBuffer, int pitch);
+void draw_vram(const uint8_t *vram);
 void draw_pixels(const uint32_t* framebuffer);
+Upload_Mode get_upload_mode();
+void set_vsync(bool enabled);
+void set_window_title(const char *title);
 int init_sdl();
 void SDL_exit();
 
-#endif
\ No newline at end of file
+extern const Video_Backend sdl_backend;
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef WAV__H
+#define WAV__H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct Wav_Stats
+{
+    uint64_t start_sample; // Position du premier échantillon sur l'horloge émulée
+    uint64_t samples;      // Échantillons écrits dans le fichier
+    uint32_t max_depth;    // Échantillons en attente au maximum
+    uint32_t stalls;       // Fois où l'émulation a attendu le thread d'écriture
+} Wav_Stats;
+
+int start_wav_capture(const char *path, uint64_t start_sample);
+void wav_capture_push(const int16_t *samples, uint32_t n);
+void stop_wav_capture();
+bool wav_capture_active();
+void get_wav_stats(Wav_Stats *stats);
+
+#endif
@@ -2,77 +2,40 @@
 #include "../includes/utils.h"
 #include "../includes/memory.h"
 #include "../includes/io.h"
-#include "../includes/video.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-static int cyc = 0;
-static int totcyc = 0;
-static bool mid_int = true;
-
-int get_cyc()
+uint64_t get_cyc(const CPU *cpu)
 {
-    return totcyc;
+    return cpu->clock.totcyc;
 }
 
 void init_cpu(CPU *cpu)
 {
-    memset(cpu->memory, 0, sizeof(cpu->memory));
-
-    cpu->pc = 0;
-    cpu->sp = 0x2400;
-    
-    cpu->a = 0;
-    cpu->b = 0;
-    cpu->c = 0;
-    cpu->d = 0;
-    cpu->e = 0;
-    cpu->h = 0;
-    cpu->l = 0;
-
-    cpu->z = 0;
-    cpu->c = 0;
-    cpu->ac = 0;
-    cpu->p = 0;
-    cpu->s = 0;
-
-    cpu->halted = false;
-    cpu->interrupt_enable = false;
-    cpu->interrupt_pending = false;
-    cpu->ei_pending = false;
+    memset(cpu, 0, sizeof(*cpu));
+    reset_cpu(cpu);
 }
 
-void fill_frame_buffer(CPU *cpu, uint32_t *frameBuffer) 
+// Remet la machine sous tension : la ROM, les hooks et le mode mémoire restent
+void reset_cpu(CPU *cpu)
 {
-    // Space Invaders utilise 224x256 (WxH)
-    // VRAM commence à 0x2400
-    for (int i = 0; i < 0x1C00; i++)  // 0x1C00 = taille de la VRAM 
-    {
-        uint8_t current_byte = read_memory(cpu, 0x2400 + i);
-        
-        // Calcul des coordonnées après rotation
-        int x = i / 32;        // 32 octets par ligne
-        int y = 255 - (i % 32 * 8); // 8 pixels par octet
-        
-        // Pour chaque bit dans l'octet
-        for (int bit = 0; bit < 8; bit++) 
-        {
-            // Si le bit est à 1, pixel blanc, sinon noir
-            uint32_t color = (current_byte & (1 << bit)) ? 0xFFFFFFFFu : 0xFF000000u;
-            
-            // Position dans le framebuffer
-            if ((y - bit) >= 0 && x < W) {
-                frameBuffer[x + ((y - bit) * W)] = color;
-            }
-        }
-    }
+    memset(cpu, 0, CPU_REGS_SIZE);
+    cpu->sp = 0x2400;
+    cpu->clock.totcyc = 0;
+    sched_clear(&cpu->clock.sched);
+    sched_add(&cpu->clock.sched, SCHED_MID_SCREEN, MID_SCREEN_CYCLES);
+    sched_add(&cpu->clock.sched, SCHED_VBLANK, FRAME_CYCLES);
+    memset(&cpu->io, 0, sizeof(cpu->io));
+    if (cpu->flat_memory)
+        return;
+    memset(cpu->memory + RAM_START, 0, sizeof(cpu->memory) - RAM_START);
 }
 
-void step_emu(CPU *cpu)
+// Une instruction, ou l'interrupt en attente
+static inline void step_cpu(CPU *cpu)
 {
-    int temp_cyc = 0;
     if (cpu->interrupt_enable && cpu->interrupt_pending && (cpu->ei_pending == 0))
     {
         cpu->interrupt_pending = 0;
@@ -80,39 +43,56 @@ void step_emu(CPU *cpu)
         
         cpu->interrupt_enable = 0;
         
-        temp_cyc = execute(cpu, cpu->interrupt_vector);
-        cyc += temp_cyc;
-        totcyc += temp_cyc;
+        cpu->clock.totcyc += execute(cpu, cpu->interrupt_vector);
     } 
     else if (!cpu->halted)
+        cpu->clock.totcyc += execute(cpu, read_memory(cpu, cpu->pc++));
+    else
+        cpu->clock.totcyc = cpu->clock.sched.next; // Rien ne peut se passer avant la prochaine interrupt
+}
+
+// Échéance atteinte : le périphérique agit et se replanifie une frame plus loin
+static Emu_Event run_event(CPU *cpu)
+{
+    Sched_Event ev;
+
+    if (!sched_pop(&cpu->clock.sched, &ev))
+        return EMU_STEP;
+    sched_add(&cpu->clock.sched, ev.id, ev.at + FRAME_CYCLES);
+    // ROM de test : pas de borne autour du CPU, donc ni RST 1 ni RST 2
+    if (cpu->flat_memory)
+        return ev.id == SCHED_MID_SCREEN ? EMU_MID_FRAME : EMU_END_FRAME;
+    if (ev.id == SCHED_MID_SCREEN)
     {
-        temp_cyc = execute(cpu, read_memory(cpu, cpu->pc++));
-        cyc += temp_cyc;
-        totcyc += temp_cyc;
-    }
-    if (cyc >= 33333)
-    {
-        mid_int = true;
-        cyc -= 33333;
         if (cpu->interrupt_enable)
-        {
-            ask_interrupt(cpu, 0xD7);
-            // 1) convertir VRAM -> framebuffer
-            uint32_t fb[W*H];
-            fill_frame_buffer(cpu, fb);
-            // 2) dessiner à l’écran
-            draw_pixels(fb);
-            // exit(0);
-        }
+            ask_interrupt(cpu, 0xCF);
+        return EMU_MID_FRAME;
     }
-    else if ((cyc >= 16667) && mid_int)
+    if (cpu->interrupt_enable)
     {
-        mid_int = false;
-        if (cpu->interrupt_enable)
-        {
-            ask_interrupt(cpu, 0xCF);
-        }
+        ask_interrupt(cpu, 0xD7);
+        // Envoie la VRAM brute, l'hôte choisit comment l'afficher
+        if (cpu->hooks.frame)
+            cpu->hooks.frame(cpu->hooks.frame_user, get_vram(cpu), cpu->clock.totcyc);
     }
+    return EMU_END_FRAME;
+}
+
+// Exécute une instruction (ou une interrupt), signale le milieu et la fin de frame
+Emu_Event step_emu(CPU *cpu)
+{
+    step_cpu(cpu);
+    if (cpu->clock.totcyc < cpu->clock.sched.next)
+        return EMU_STEP;
+    return run_event(cpu);
+}
+
+// Comme step_emu, mais d'une traite jusqu'à la prochaine échéance
+Emu_Event run_emu(CPU *cpu)
+{
+    while (cpu->clock.totcyc < cpu->clock.sched.next)
+        step_cpu(cpu);
+    return run_event(cpu);
 }
 
 // demander une interrupt (pour les périphérique)
@@ -145,7 +125,7 @@ void check_condition_bits(CPU *cpu, bool s, bool z, bool p, bool c, uint16_t dat
     }
 }
 
-uint8_t get_f_flags(CPU *cpu)
+uint8_t get_f_flags(const CPU *cpu)
 {
     return (cpu->s << 7) | (cpu->z << 6) | (0 << 5) | (cpu->ac << 4) | (0 << 3) | (cpu->p << 2) | (1 << 1) | (cpu->cy);
 }
@@ -176,7 +156,7 @@ int execute(CPU *cpu, uint8_t opcode)
             cpu->b = read_memory(cpu, cpu->pc++);
             return 10;
         case 0x02: // STAX B
-            write_memory(((cpu->b << 8) | cpu->c), cpu->a);
+            write_memory(cpu, ((cpu->b << 8) | cpu->c), cpu->a);
             return 7;
         case 0x03: // INX B
             cpu->c++;
@@ -252,7 +232,7 @@ int execute(CPU *cpu, uint8_t opcode)
             cpu->d = read_memory(cpu, cpu->pc++);
             return 10;
         case 0x12: // STAX D
-            write_memory(((cpu->d << 8) | cpu->e), cpu->a);
+            write_memory(cpu, ((cpu->d << 8) | cpu->e), cpu->a);
             return 7;
         case 0x13: // INX D
             cpu->e++;
@@ -331,8 +311,8 @@ int execute(CPU *cpu, uint8_t opcode)
             lo = read_memory(cpu, cpu->pc++);
             hi = read_memory(cpu, cpu->pc++);
             addr = ((hi << 8) | lo);
-            write_memory(addr, cpu->l);
-            write_memory(addr+1, cpu->h);
+            write_memory(cpu, addr, cpu->l);
+            write_memory(cpu, addr+1, cpu->h);
             return 16;
         case 0x23: // INX H
             cpu->l++;
@@ -425,7 +405,7 @@ int execute(CPU *cpu, uint8_t opcode)
             lo = read_memory(cpu, cpu->pc++);
             hi = read_memory(cpu, cpu->pc++);
             addr = ((hi << 8) | lo);
-            write_memory(addr, cpu->a);
+            write_memory(cpu, addr, cpu->a);
             return 13;
         case 0x33: // INX SP
             cpu->sp++;
@@ -435,18 +415,18 @@ int execute(CPU *cpu, uint8_t opcode)
             // for Auxiliary carry
             cpu->ac = (((read_memory(cpu, ((cpu->h << 8) | cpu->l)) & 0xF) + 1) > 0xF);
             check_condition_bits(cpu, 1, 1, 1, 0, res_16bits);
-            write_memory(((cpu->h << 8) | cpu->l), (uint8_t)(res_16bits & 0xFF));
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), (uint8_t)(res_16bits & 0xFF));
             return 10;
         case 0x35: // DCR M
             lo = read_memory(cpu, ((cpu->h << 8) | cpu->l)) - 1;
             // for Auxiliary carry
             cpu->ac = !((lo & 0xF) == 0xF);
             check_condition_bits(cpu, 1, 1, 1, 0, lo);
-            write_memory(((cpu->h << 8) | cpu->l), lo);
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), lo);
             return 10;
         case 0x36: // MVI M, d8
             addr = (cpu->h << 8) | cpu->l;
-            write_memory(addr, read_memory(cpu, cpu->pc++));
+            write_memory(cpu, addr, read_memory(cpu, cpu->pc++));
             return 10;
         case 0x37: // STC
             cpu->cy = 1;
@@ -634,28 +614,28 @@ int execute(CPU *cpu, uint8_t opcode)
             cpu->l = cpu->a;
             return 5;
         case 0x70: // MOV M, B
-            write_memory(((cpu->h << 8) | cpu->l), cpu->b);
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), cpu->b);
             return 7;
         case 0x71: // MOV M, C
-            write_memory(((cpu->h << 8) | cpu->l), cpu->c);
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), cpu->c);
             return 7;
         case 0x72: // MOV M, D
-            write_memory(((cpu->h << 8) | cpu->l), cpu->d);
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), cpu->d);
             return 7;
         case 0x73: // MOV M, E
-            write_memory(((cpu->h << 8) | cpu->l), cpu->e);
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), cpu->e);
             return 7;
         case 0x74: // MOV M, H
-            write_memory(((cpu->h << 8) | cpu->l), cpu->h);
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), cpu->h);
             return 7;
         case 0x75: // MOV M, L
-            write_memory(((cpu->h << 8) | cpu->l), cpu->l);
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), cpu->l);
             return 7;
         case 0x76: // HLT
             cpu->halted = true;
             return 7;
         case 0x77: // MOV M, A
-            write_memory(((cpu->h << 8) | cpu->l), cpu->a);
+            write_memory(cpu, ((cpu->h << 8) | cpu->l), cpu->a);
             return 7;
         case 0x78: // MOV A, B
             cpu->a = cpu->b;
@@ -1142,8 +1122,8 @@ int execute(CPU *cpu, uint8_t opcode)
             }
             return 11;
         case 0xC5: // PUSH B
-            write_memory(--cpu->sp, cpu->b);
-            write_memory(--cpu->sp, cpu->c);
+            write_memory(cpu, --cpu->sp, cpu->b);
+            write_memory(cpu, --cpu->sp, cpu->c);
             return 11;
         case 0xC6: // ADI d8
             lo = read_memory(cpu, cpu->pc++);
@@ -1228,7 +1208,7 @@ int execute(CPU *cpu, uint8_t opcode)
             return 10;
         case 0xD3: // OUT d8
             lo = read_memory(cpu, cpu->pc++);
-            write_io(*cpu, lo, cpu->a);
+            write_io(cpu, lo, cpu->a);
             return 10;
         case 0xD4: // CNC a16
             lo = read_memory(cpu, cpu->pc++);
@@ -1241,8 +1221,8 @@ int execute(CPU *cpu, uint8_t opcode)
             }
             return 11;
         case 0xD5: // PUSH D
-            write_memory(--cpu->sp, cpu->d);
-            write_memory(--cpu->sp, cpu->e);
+            write_memory(cpu, --cpu->sp, cpu->d);
+            write_memory(cpu, --cpu->sp, cpu->e);
             return 11;
         case 0xD6: // SUI d8
             lo = read_memory(cpu, cpu->pc++);
@@ -1275,7 +1255,7 @@ int execute(CPU *cpu, uint8_t opcode)
             return 10;
         case 0xDB: // IN d8
             lo = read_memory(cpu, cpu->pc++);
-            cpu->a = read_io(lo);
+            cpu->a = read_io(cpu, lo);
             return 10;
         case 0xDC: // CC a16
             lo = read_memory(cpu, cpu->pc++);
@@ -1326,8 +1306,8 @@ int execute(CPU *cpu, uint8_t opcode)
         case 0xE3: // XTHL
             lo = read_memory(cpu, cpu->sp);
             hi = read_memory(cpu, cpu->sp+1);
-            write_memory(cpu->sp, cpu->l);
-            write_memory(cpu->sp+1, cpu->h);
+            write_memory(cpu, cpu->sp, cpu->l);
+            write_memory(cpu, cpu->sp+1, cpu->h);
             cpu->l = lo;
             cpu->h = hi;
             return 18;
@@ -1342,8 +1322,8 @@ int execute(CPU *cpu, uint8_t opcode)
             }
             return 11;
         case 0xE5: // PUSH H
-            write_memory(--cpu->sp, cpu->h);
-            write_memory(--cpu->sp, cpu->l);
+            write_memory(cpu, --cpu->sp, cpu->h);
+            write_memory(cpu, --cpu->sp, cpu->l);
             return 11;
         case 0xE6: // ANI d8
             lo = read_memory(cpu, cpu->pc++);
@@ -1450,8 +1430,8 @@ int execute(CPU *cpu, uint8_t opcode)
             }
             return 11;
         case 0xF5: // PUSH PSW
-            write_memory(--cpu->sp, cpu->a);
-            write_memory(--cpu->sp, get_f_flags(cpu));
+            write_memory(cpu, --cpu->sp, cpu->a);
+            write_memory(cpu, --cpu->sp, get_f_flags(cpu));
             return 11;
         case 0xF6: // ORI d8
             lo = read_memory(cpu, cpu->pc++);
@@ -1520,8 +1500,8 @@ int execute(CPU *cpu, uint8_t opcode)
 
 void call(CPU *cpu, uint16_t addr)
 {
-    write_memory(--cpu->sp, ((cpu->pc >> 8) & 0xFF));
-    write_memory(--cpu->sp, (cpu->pc & 0xFF));
+    write_memory(cpu, --cpu->sp, ((cpu->pc >> 8) & 0xFF));
+    write_memory(cpu, --cpu->sp, (cpu->pc & 0xFF));
     cpu->pc = addr;
 }
 
@@ -0,0 +1,322 @@
+#include "../includes/filter.h"
+#include "../includes/pool.h"
+#include "../includes/video.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+Post-traitement entre la conversion VRAM -> ARGB et l'affichage.
+L'image source (W x H) est découpée en bandes de TILE_ROWS lignes, chaque bande
+est une tâche du pool de threads. Les filtres ne lisent que la source, les
+bandes peuvent donc être traitées dans n'importe quel ordre.
+*/
+
+#define TILE_ROWS 16
+#define MAX_SCALE 8
+
+typedef struct Filter_Job
+{
+    const uint32_t *src;
+    uint32_t *dst;
+    int dst_pitch; // en pixels
+} Filter_Job;
+
+static Filter_Kind kind = FILTER_NONE;
+static int scale = 1;
+static uint32_t crt_mask[W * MAX_SCALE]; // Masque de phosphores R/G/B d'une ligne de sortie
+
+static const struct { const char *name; Filter_Kind kind; } filter_names[] = {
+    { "none",      FILTER_NONE },
+    { "nearest",   FILTER_NEAREST },
+    { "scale2x",   FILTER_SCALE2X },
+    { "scale3x",   FILTER_SCALE3X },
+    { "scanlines", FILTER_SCANLINES },
+    { "crt",       FILTER_CRT },
+};
+
+int parse_filter(const char *name, Filter_Kind *out)
+{
+    for (size_t i = 0; i < sizeof(filter_names) / sizeof(filter_names[0]); i++)
+    {
+        if (strcmp(name, filter_names[i].name) == 0)
+        {
+            *out = filter_names[i].kind;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// scale n'est utilisé que par nearest / scanlines / crt, scale2x et scale3x imposent le leur
+int init_filter(Filter_Kind k, int s, int nb_threads)
+{
+    if (k == FILTER_SCALE2X)
+        s = 2;
+    else if (k == FILTER_SCALE3X)
+        s = 3;
+    else if (k == FILTER_NONE)
+        s = 1;
+    if (s < 1 || s > MAX_SCALE)
+        return -1;
+    if ((k == FILTER_SCANLINES || k == FILTER_CRT) && s < 2)
+        s = 2;
+
+    kind = k;
+    scale = s;
+    for (int x = 0; x < W * scale; x++)
+    {
+        static const uint32_t keep[3] = { 0xFFFF0000u, 0xFF00FF00u, 0xFF0000FFu };
+        crt_mask[x] = keep[x % 3];
+    }
+    if (kind != FILTER_NONE)
+        return init_pool(nb_threads);
+    return 0;
+}
+
+Filter_Kind get_filter()
+{
+    return kind;
+}
+
+int get_filter_scale()
+{
+    return scale;
+}
+
+// Duplique chaque pixel horizontalement scale fois
+static void expand_row(const uint32_t *src, uint32_t *dst)
+{
+    int x = 0;
+#ifdef __SSE2__
+    if (scale == 2)
+    {
+        for (; x + 4 <= W; x += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+            _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i *)(dst + x * 2 + 4), _mm_unpackhi_epi32(v, v));
+        }
+    }
+    else if (scale == 4)
+    {
+        for (; x + 4 <= W; x += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+            __m128i lo = _mm_unpacklo_epi32(v, v);
+            __m128i hi = _mm_unpackhi_epi32(v, v);
+            _mm_storeu_si128((__m128i *)(dst + x * 4), _mm_unpacklo_epi64(lo, lo));
+            _mm_storeu_si128((__m128i *)(dst + x * 4 + 4), _mm_unpackhi_epi64(lo, lo));
+            _mm_storeu_si128((__m128i *)(dst + x * 4 + 8), _mm_unpacklo_epi64(hi, hi));
+            _mm_storeu_si128((__m128i *)(dst + x * 4 + 12), _mm_unpackhi_epi64(hi, hi));
+        }
+    }
+#endif
+    for (; x < W; x++)
+        for (int i = 0; i < scale; i++)
+            dst[x * scale + i] = src[x];
+}
+
+// Assombrit une ligne de moitié (ligne de balayage entre deux lignes CRT)
+static void darken_row(const uint32_t *src, uint32_t *dst, int n)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i half = _mm_set1_epi32(0x007F7F7F);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+    for (; x + 4 <= n; x += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+        v = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 1), half), alpha);
+        _mm_storeu_si128((__m128i *)(dst + x), v);
+    }
+#endif
+    for (; x < n; x++)
+        dst[x] = ((src[x] >> 1) & 0x007F7F7Fu) | 0xFF000000u;
+}
+
+// Masque à grille d'ouverture : chaque colonne garde une composante, les autres à moitié
+static void mask_row(uint32_t *row, int n)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i half = _mm_set1_epi32(0x7F7F7F7F);
+    for (; x + 4 <= n; x += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(row + x));
+        __m128i m = _mm_loadu_si128((const __m128i *)(crt_mask + x));
+        v = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 1), half), _mm_and_si128(v, m));
+        _mm_storeu_si128((__m128i *)(row + x), v);
+    }
+#endif
+    for (; x < n; x++)
+        row[x] = ((row[x] >> 1) & 0x7F7F7F7Fu) | (row[x] & crt_mask[x]);
+}
+
+static void nearest_rows(const Filter_Job *job, int y0, int y1)
+{
+    int dst_w = W * scale;
+
+    for (int y = y0; y < y1; y++)
+    {
+        uint32_t *first = job->dst + (y * scale) * job->dst_pitch;
+        expand_row(job->src + y * W, first);
+        if (kind == FILTER_CRT)
+            mask_row(first, dst_w);
+        for (int i = 1; i < scale; i++)
+        {
+            uint32_t *row = first + i * job->dst_pitch;
+            if (i == scale - 1 && (kind == FILTER_SCANLINES || kind == FILTER_CRT))
+                darken_row(first, row, dst_w);
+            else
+                memcpy(row, first, dst_w * sizeof(uint32_t));
+        }
+    }
+}
+
+/*
+Scale2x (EPX), pour un pixel E et ses voisins :
+    B        E0 E1
+  D E F  ->  E2 E3
+    H
+*/
+static void scale2x_pixel(uint32_t b, uint32_t d, uint32_t e, uint32_t f, uint32_t h, uint32_t *out0, uint32_t *out1)
+{
+    if (b != h && d != f)
+    {
+        out0[0] = d == b ? d : e;
+        out0[1] = b == f ? f : e;
+        out1[0] = d == h ? d : e;
+        out1[1] = h == f ? f : e;
+    }
+    else
+    {
+        out0[0] = out0[1] = out1[0] = out1[1] = e;
+    }
+}
+
+#ifdef __SSE2__
+static inline __m128i select_si128(__m128i m, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+#endif
+
+static void scale2x_rows(const Filter_Job *job, int y0, int y1)
+{
+    for (int y = y0; y < y1; y++)
+    {
+        const uint32_t *up = job->src + (y > 0 ? y - 1 : y) * W;
+        const uint32_t *row = job->src + y * W;
+        const uint32_t *down = job->src + (y < H - 1 ? y + 1 : y) * W;
+        uint32_t *out0 = job->dst + (y * 2) * job->dst_pitch;
+        uint32_t *out1 = out0 + job->dst_pitch;
+        int x = 0;
+
+        // Bord gauche (D n'existe pas) en scalaire
+        for (; x < 4; x++)
+            scale2x_pixel(up[x], row[x > 0 ? x - 1 : x], row[x], row[x + 1], down[x], out0 + x * 2, out1 + x * 2);
+#ifdef __SSE2__
+        for (; x + 4 <= W - 4; x += 4)
+        {
+            __m128i b = _mm_loadu_si128((const __m128i *)(up + x));
+            __m128i d = _mm_loadu_si128((const __m128i *)(row + x - 1));
+            __m128i e = _mm_loadu_si128((const __m128i *)(row + x));
+            __m128i f = _mm_loadu_si128((const __m128i *)(row + x + 1));
+            __m128i h = _mm_loadu_si128((const __m128i *)(down + x));
+            // b != h && d != f
+            __m128i ok = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f)), _mm_set1_epi32(-1));
+            __m128i e0 = select_si128(_mm_and_si128(ok, _mm_cmpeq_epi32(d, b)), d, e);
+            __m128i e1 = select_si128(_mm_and_si128(ok, _mm_cmpeq_epi32(b, f)), f, e);
+            __m128i e2 = select_si128(_mm_and_si128(ok, _mm_cmpeq_epi32(d, h)), d, e);
+            __m128i e3 = select_si128(_mm_and_si128(ok, _mm_cmpeq_epi32(h, f)), f, e);
+            _mm_storeu_si128((__m128i *)(out0 + x * 2), _mm_unpacklo_epi32(e0, e1));
+            _mm_storeu_si128((__m128i *)(out0 + x * 2 + 4), _mm_unpackhi_epi32(e0, e1));
+            _mm_storeu_si128((__m128i *)(out1 + x * 2), _mm_unpacklo_epi32(e2, e3));
+            _mm_storeu_si128((__m128i *)(out1 + x * 2 + 4), _mm_unpackhi_epi32(e2, e3));
+        }
+#endif
+        // Bord droit (F n'existe pas pour le dernier pixel)
+        for (; x < W; x++)
+            scale2x_pixel(up[x], row[x - 1], row[x], row[x < W - 1 ? x + 1 : x], down[x], out0 + x * 2, out1 + x * 2);
+    }
+}
+
+/*
+Scale3x, voisinage complet :
+  A B C      E0 E1 E2
+  D E F  ->  E3 E4 E5
+  G H I      E6 E7 E8
+Pas de version SIMD, c'est le pool de threads qui fait le travail.
+*/
+static void scale3x_rows(const Filter_Job *job, int y0, int y1)
+{
+    for (int y = y0; y < y1; y++)
+    {
+        const uint32_t *up = job->src + (y > 0 ? y - 1 : y) * W;
+        const uint32_t *row = job->src + y * W;
+        const uint32_t *down = job->src + (y < H - 1 ? y + 1 : y) * W;
+        uint32_t *out0 = job->dst + (y * 3) * job->dst_pitch;
+        uint32_t *out1 = out0 + job->dst_pitch;
+        uint32_t *out2 = out1 + job->dst_pitch;
+
+        for (int x = 0; x < W; x++)
+        {
+            int xl = x > 0 ? x - 1 : x;
+            int xr = x < W - 1 ? x + 1 : x;
+            uint32_t a = up[xl], b = up[x], c = up[xr];
+            uint32_t d = row[xl], e = row[x], f = row[xr];
+            uint32_t g = down[xl], h = down[x], i = down[xr];
+            uint32_t *o0 = out0 + x * 3, *o1 = out1 + x * 3, *o2 = out2 + x * 3;
+
+            if (b != h && d != f)
+            {
+                o0[0] = d == b ? d : e;
+                o0[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+                o0[2] = b == f ? f : e;
+                o1[0] = (d == b && e != g) || (d == h && e != a) ? d : e;
+                o1[1] = e;
+                o1[2] = (b == f && e != i) || (h == f && e != c) ? f : e;
+                o2[0] = d == h ? d : e;
+                o2[1] = (d == h && e != i) || (h == f && e != g) ? h : e;
+                o2[2] = h == f ? f : e;
+            }
+            else
+            {
+                o0[0] = o0[1] = o0[2] = e;
+                o1[0] = o1[1] = o1[2] = e;
+                o2[0] = o2[1] = o2[2] = e;
+            }
+        }
+    }
+}
+
+static void filter_tile(void *user, int task)
+{
+    const Filter_Job *job = user;
+    int y0 = task * TILE_ROWS;
+    int y1 = y0 + TILE_ROWS < H ? y0 + TILE_ROWS : H;
+
+    switch (kind)
+    {
+        case FILTER_SCALE2X:
+            scale2x_rows(job, y0, y1);
+            break;
+        case FILTER_SCALE3X:
+            scale3x_rows(job, y0, y1);
+            break;
+        default:
+            nearest_rows(job, y0, y1);
+            break;
+    }
+}
+
+// src: image W x H, dst: image (W * scale) x (H * scale), dst_pitch en pixels
+void apply_filter(const uint32_t *src, uint32_t *dst, int dst_pitch)
+{
+    Filter_Job job = { src, dst, dst_pitch };
+    pool_run(filter_tile, &job, (H + TILE_ROWS - 1) / TILE_ROWS);
+}
@@ -0,0 +1,293 @@
+#include "../includes/forkserv.h"
+#include "../includes/invaders.h"
+#include "../includes/unixsock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Fork server : une machine chauffée (jusqu'à une frame donnée) attend des
+demandes sur une socket Unix locale. Chaque demande est servie par un fork()
+de la machine : l'enfant part de l'état exact du parent, la ROM et les pages
+qu'il ne touche pas restent partagées par copie à l'écriture. L'enfant joue
+son script d'entrées, répond sur la connexion puis se termine.
+
+Protocole, une ligne par connexion :
+  RUN <frames> <port1>x<n> ...  les entrées du joueur 1 en hexa, n frames
+                                chacune, répétées en boucle
+  QUIT                          arrête le serveur
+Réponse : OK frame <f> cycle <c> hash <h> score <s> ships <k> us <durée>,
+ou ERR <raison>.
+*/
+
+#ifdef _WIN32
+
+int run_fork_server(I8080_Machine *m, const char *path)
+{
+    (void)m;
+    (void)path;
+    printf("ERR: the fork server needs fork() and Unix sockets\n");
+    return -1;
+}
+
+int run_fork_client(const char *path, const char *request, int count)
+{
+    (void)path;
+    (void)request;
+    (void)count;
+    printf("ERR: the fork server needs fork() and Unix sockets\n");
+    return -1;
+}
+
+#else
+
+# include <sys/wait.h>
+# include <poll.h>
+# include <signal.h>
+# include <time.h>
+# include <unistd.h>
+
+typedef struct Fork_Script
+{
+    uint32_t frames;
+    uint8_t port1[FORK_MAX_INPUTS];
+    uint32_t len[FORK_MAX_INPUTS];
+    int nb_inputs;
+} Fork_Script;
+
+static uint64_t now_us()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int parse_script(char *line, Fork_Script *script)
+{
+    char *tok = strtok(line + 3, " ");
+    char *end;
+
+    if (!tok)
+        return -1;
+    script->frames = (uint32_t)strtoul(tok, &end, 10);
+    if (*end || !script->frames)
+        return -1;
+    script->nb_inputs = 0;
+    while ((tok = strtok(NULL, " ")))
+    {
+        if (script->nb_inputs == FORK_MAX_INPUTS)
+            return -1;
+        unsigned long port = strtoul(tok, &end, 16);
+        if (*end != 'x' || port > 0xFF)
+            return -1;
+        unsigned long n = strtoul(end + 1, &end, 10);
+        if (*end || !n)
+            return -1;
+        script->port1[script->nb_inputs] = (uint8_t)port;
+        script->len[script->nb_inputs] = (uint32_t)n;
+        script->nb_inputs++;
+    }
+    return 0;
+}
+
+// Dans l'enfant : le script joué depuis l'état hérité du parent
+static void run_child(I8080_Machine *m, const Fork_Script *script, int conn)
+{
+    uint64_t t0 = now_us();
+    int input = 0;
+    uint32_t left = script->nb_inputs ? script->len[0] : 0;
+    char reply[256];
+
+    for (uint32_t f = 0; f < script->frames; f++)
+    {
+        if (script->nb_inputs)
+        {
+            if (!left)
+            {
+                input = (input + 1) % script->nb_inputs;
+                left = script->len[input];
+            }
+            i8080_set_inputs(m, script->port1[input], 0);
+            left--;
+        }
+        else
+            i8080_set_inputs(m, 0, 0);
+        i8080_run_frame(m);
+    }
+    snprintf(reply, sizeof(reply), "OK frame %u cycle %llu hash %016llx score %u ships %u us %llu\n",
+        script->frames, (unsigned long long)i8080_get_cycles(m), (unsigned long long)i8080_frame_hash(m),
+        invaders_score(m), invaders_ships(m), (unsigned long long)(now_us() - t0));
+    write_all(conn, reply);
+}
+
+int run_fork_server(I8080_Machine *m, const char *path)
+{
+    struct sockaddr_un addr;
+    static char line[FORK_MAX_REQUEST];
+    static Fork_Script script;
+    uint32_t served = 0, refused = 0;
+    int live = 0, live_max = 0;
+    uint64_t fork_us = 0, fork_max_us = 0;
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0 || unix_address(path, &addr) != 0)
+    {
+        printf("ERR: could not open the fork server socket %s\n", path);
+        return -1;
+    }
+    unlink(path);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sock, 64) != 0)
+    {
+        perror("Error bind fork server:");
+        close(sock);
+        return -1;
+    }
+    // Un client parti avant la réponse ne doit pas tuer le serveur
+    signal(SIGPIPE, SIG_IGN);
+    printf("Fork server: listening on %s at cycle %llu\n", path, (unsigned long long)i8080_get_cycles(m));
+    fflush(stdout);
+
+    while (1)
+    {
+        int conn = accept(sock, NULL, NULL);
+        if (conn < 0)
+            continue;
+        if (read_line(conn, line, sizeof(line)) < 0)
+        {
+            close(conn);
+            continue;
+        }
+        if (strcmp(line, "QUIT") == 0)
+        {
+            write_all(conn, "OK bye\n");
+            close(conn);
+            break;
+        }
+        if (strncmp(line, "RUN ", 4) != 0 || parse_script(line, &script) != 0)
+        {
+            write_all(conn, "ERR bad request\n");
+            close(conn);
+            refused++;
+            continue;
+        }
+        // Trop d'enfants en vol : on attend qu'un se termine
+        while (waitpid(-1, NULL, live >= FORK_MAX_CHILDREN ? 0 : WNOHANG) > 0)
+            live--;
+
+        uint64_t t0 = now_us();
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(sock);
+            run_child(m, &script, conn);
+            close(conn);
+            _exit(0);
+        }
+        uint64_t cost = now_us() - t0;
+        close(conn);
+        if (pid < 0)
+        {
+            refused++;
+            continue;
+        }
+        served++;
+        live++;
+        if (live > live_max)
+            live_max = live;
+        fork_us += cost;
+        if (cost > fork_max_us)
+            fork_max_us = cost;
+    }
+    while (live > 0 && waitpid(-1, NULL, 0) > 0)
+        live--;
+    close(sock);
+    unlink(path);
+    printf("Fork server: %u children (%u requests refused), max %d alive, fork() avg %.0f / max %llu us\n",
+        served, refused, live_max, served ? (double)fork_us / served : 0, (unsigned long long)fork_max_us);
+    return 0;
+}
+
+static int connect_server(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0 || unix_address(path, &addr) != 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Envoie count fois la même demande, 64 connexions en vol au plus. Les enfants
+// partant tous du même état, les réponses doivent être identiques
+int run_fork_client(const char *path, const char *request, int count)
+{
+    enum { IN_FLIGHT = 64 };
+    struct pollfd fds[IN_FLIGHT];
+    char first[256] = "", reply[256];
+    int sent = 0, done = 0, open = 0, mismatches = 0, failed = 0;
+    uint64_t t0 = now_us();
+
+    char *req = malloc(strlen(request) + 2);
+    if (!req)
+        return -1;
+    sprintf(req, "%s\n", request);
+    while (done < count)
+    {
+        while (open < IN_FLIGHT && sent < count)
+        {
+            int fd = connect_server(path);
+            sent++;
+            if (fd < 0)
+            {
+                failed++;
+                done++;
+                continue;
+            }
+            write_all(fd, req);
+            fds[open++] = (struct pollfd){ fd, POLLIN, 0 };
+        }
+        if (!open)
+            continue;
+        poll(fds, open, -1);
+        for (int i = 0; i < open; i++)
+        {
+            if (!fds[i].revents)
+                continue;
+            int len = read_line(fds[i].fd, reply, sizeof(reply));
+            close(fds[i].fd);
+            fds[i--] = fds[--open];
+            done++;
+            if (len < 0 || strncmp(reply, "OK", 2) != 0)
+            {
+                failed++;
+                if (len >= 0 && !first[0])
+                    printf("%s\n", reply);
+                continue;
+            }
+            // La durée mesurée par l'enfant varie, pas le reste
+            char *us = strstr(reply, " us ");
+            if (us)
+                *us = '\0';
+            if (!first[0])
+            {
+                snprintf(first, sizeof(first), "%s", reply);
+                printf("%s\n", first);
+            }
+            else if (strcmp(first, reply) != 0)
+                mismatches++;
+        }
+    }
+    double seconds = (now_us() - t0) / 1000000.0;
+    printf("Fork client: %d runs in %.2f s (%.0f runs/s), %d failed, %d mismatches\n",
+        count, seconds, seconds > 0 ? count / seconds : 0, failed, mismatches);
+    free(req);
+    return failed ? -1 : 0;
+}
+
+#endif
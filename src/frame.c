@@ -0,0 +1,186 @@
+#include "../includes/frame.h"
+#include "../includes/memory.h"
+#include "../includes/video.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+Sortie vidéo de l'émulateur. step_emu() soumet la VRAM brute à chaque frame,
+le backend choisi au démarrage l'affiche (sdl), la jette (null) ou la garde en
+mémoire (offscreen). Les consommateurs (enregistreur, etc.) reçoivent la même
+frame ; la conversion en ARGB n'est faite que s'ils la demandent.
+*/
+
+#define MAX_CONSUMERS 8
+
+typedef struct Consumer
+{
+    Frame_Consumer fn;
+    void *user;
+} Consumer;
+
+static const Video_Backend *backend = NULL;
+static Consumer consumers[MAX_CONSUMERS];
+static int nb_consumers = 0;
+static uint32_t frame_number = 0;
+static uint8_t offscreen_vram[VRAM_SIZE];
+static uint64_t last_hash = 0;
+static bool present_skip = false; // Décidé par le pacer : frame émulée mais pas affichée
+static bool output_present = true;  // Faux pendant le run-ahead, sauf pour la frame d'avance
+static bool output_consume = true;  // Faux pour les frames jouées en avance puis annulées
+static uint64_t last_present_hash = 0;
+static bool presented_once = false;
+
+// Backend null : aucune sortie, pour les machines sans affichage
+static int null_init()
+{
+    return 0;
+}
+
+static void null_present(const Frame *frame)
+{
+    (void)frame;
+}
+
+static void null_quit()
+{
+}
+
+// Backend offscreen : la dernière frame reste en mémoire, convertie à la demande
+static void offscreen_present(const Frame *frame)
+{
+    if (frame->changed)
+        memcpy(offscreen_vram, frame->vram, VRAM_SIZE);
+}
+
+static const Video_Backend null_backend = { "null", false, null_init, null_present, null_quit };
+static const Video_Backend offscreen_backend = { "offscreen", false, null_init, offscreen_present, null_quit };
+
+static const Video_Backend *backends[] = { &sdl_backend, &null_backend, &offscreen_backend };
+
+int init_video(const char *name)
+{
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++)
+    {
+        if (strcmp(name, backends[i]->name) == 0)
+        {
+            if (backends[i]->init() != 0)
+                return 1;
+            backend = backends[i];
+            return 0;
+        }
+    }
+    printf("ERR: unknown video backend %s (sdl, null, offscreen)\n", name);
+    return 1;
+}
+
+const Video_Backend *get_video_backend()
+{
+    return backend;
+}
+
+void quit_video()
+{
+    if (backend)
+        backend->quit();
+    backend = NULL;
+}
+
+int add_frame_consumer(Frame_Consumer consumer, void *user)
+{
+    if (nb_consumers >= MAX_CONSUMERS)
+        return -1;
+    consumers[nb_consumers++] = (Consumer){ consumer, user };
+    return 0;
+}
+
+void remove_frame_consumer(Frame_Consumer consumer, void *user)
+{
+    for (int i = 0; i < nb_consumers; i++)
+    {
+        if (consumers[i].fn == consumer && consumers[i].user == user)
+        {
+            consumers[i] = consumers[--nb_consumers];
+            return;
+        }
+    }
+}
+
+void submit_frame(const uint8_t *vram, uint64_t cyc)
+{
+    // Frame intermédiaire du run-ahead : ni affichée ni comptée
+    if (!output_present && !output_consume)
+        return;
+
+    Frame frame = { vram, frame_number + 1, cyc, hash_vram(vram), true };
+
+    if (output_present && backend && !present_skip)
+    {
+        // Comparée à la dernière frame affichée, qui n'est pas forcément la précédente
+        frame.changed = !presented_once || frame.hash != last_present_hash;
+        last_present_hash = frame.hash;
+        presented_once = true;
+        backend->present(&frame);
+    }
+    if (!output_consume)
+        return;
+    // La première frame est toujours considérée comme nouvelle
+    frame_number++;
+    frame.changed = frame_number == 1 || frame.hash != last_hash;
+    last_hash = frame.hash;
+    for (int i = 0; i < nb_consumers; i++)
+        consumers[i].fn(&frame, consumers[i].user);
+}
+
+uint32_t get_frame_number()
+{
+    return frame_number;
+}
+
+// Les consommateurs reçoivent toujours la frame, seul l'affichage est sauté
+void set_present_skip(bool skip)
+{
+    present_skip = skip;
+}
+
+bool is_present_skipped()
+{
+    return present_skip;
+}
+
+// Affiche la VRAM sans la compter ni la passer aux consommateurs (rewind)
+void present_frame(const uint8_t *vram, uint64_t cyc)
+{
+    bool present = output_present;
+    bool consume = output_consume;
+
+    set_frame_output(true, false);
+    submit_frame(vram, cyc);
+    set_frame_output(present, consume);
+}
+
+// present: la frame va au backend vidéo. consume: elle est numérotée et passée
+// aux consommateurs. Le run-ahead affiche des frames qui ne comptent pas.
+void set_frame_output(bool present, bool consume)
+{
+    output_present = present;
+    output_consume = consume;
+}
+
+void get_frame_output(bool *present, bool *consume)
+{
+    *present = output_present;
+    *consume = output_consume;
+}
+
+// Conversion ARGB W x H à la demande (avec l'overlay), pour les consommateurs
+void frame_to_argb(const Frame *frame, uint32_t *frameBuffer)
+{
+    fill_frame_buffer(frame->vram, frameBuffer, W);
+}
+
+const uint8_t *get_offscreen_vram()
+{
+    return offscreen_vram;
+}
@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../includes/i8080.h"
+#include "../includes/movie.h"
+#include "../includes/invaders.h"
+#include "../includes/forkserv.h"
+#include "../includes/session.h"
+#include "../includes/stream.h"
+
+/*
+Exécutable de test sans SDL : uniquement libi8080 et les films d'entrées.
+Émule le plus vite possible, puis affiche la vitesse et le hash de la VRAM,
+les mêmes que ceux d'emu pour le même film.
+*/
+
+static uint32_t frame_number = 0;
+
+static void count_frame(void *user, const uint8_t *vram, uint64_t cyc)
+{
+    (void)user;
+    (void)vram;
+    (void)cyc;
+    frame_number++;
+}
+
+// Seek (par défaut jusqu'à la dernière frame) puis résultat, comparable à un rejeu complet
+static int play_session(I8080_Machine *m, const char *path, long seek, bool verify)
+{
+    Session_Stats stats;
+
+    if (open_session(path) != 0)
+        return -1;
+    uint32_t target = seek >= 0 ? (uint32_t)seek : get_session_frames();
+    int ret = session_seek(m, target, verify);
+    get_session_stats(NULL, &stats);
+    if (ret < 0)
+    {
+        printf("ERR: could not seek to frame %u of %s (%u frames)\n", target, path, get_session_frames());
+        close_session();
+        return -1;
+    }
+    printf("Session: seek to frame %u from checkpoint %u, %u frames emulated in %.1f ms\n",
+        target, stats.seek_from, stats.seek_frames, stats.seek_ms);
+    if (verify)
+    {
+        if (stats.mismatches)
+            printf("Session: %u checkpoints verified, %u mismatches, first at frame %u\n",
+                stats.checkpoints, stats.mismatches, stats.first_mismatch);
+        else
+            printf("Session: %u checkpoints verified, replay is deterministic\n", stats.checkpoints);
+    }
+    printf("Session: frame %u at cycle %llu, VRAM hash %016llx, state hash %016llx\n", target,
+        (unsigned long long)i8080_get_cycles(m), (unsigned long long)i8080_frame_hash(m),
+        (unsigned long long)i8080_state_hash(m));
+    close_session();
+    return 0;
+}
+
+// Viewer sans fenêtre d'un emu lancé avec --stream : vérifie chaque frame reçue
+static int view_stream(const char *path, uint32_t max_frames, long input)
+{
+    static uint8_t vram[I8080_VRAM_SIZE];
+    struct timespec pause = { 0, 1000000 };
+    Stream_Info info;
+    Stream_Stats stats;
+    uint32_t frames = 0;
+    int got = 0;
+
+    if (stream_attach(path) != 0)
+    {
+        printf("ERR: could not attach to stream %s\n", path);
+        return -1;
+    }
+    if (input >= 0)
+        stream_send_inputs((uint8_t)input, 0);
+    while ((!max_frames || frames < max_frames) && (got = stream_next_frame(vram, &info)) >= 0)
+    {
+        if (got)
+            frames++;
+        else
+            nanosleep(&pause, NULL);
+    }
+    if (got < 0)
+        printf("Stream view: the emulator closed the stream\n");
+    get_stream_stats(NULL, &stats);
+    printf("Stream view: %u frames (%u keyframes), %u lost, %u hash mismatches, %llu bytes read\n",
+        stats.frames, stats.keyframes, stats.lost, stats.bad_hash, (unsigned long long)stats.bytes);
+    if (frames)
+        printf("Stream view: frame %u at cycle %llu, VRAM hash %016llx\n", info.number,
+            (unsigned long long)info.cyc, (unsigned long long)info.hash);
+    stream_detach();
+    return stats.bad_hash ? -1 : 0;
+}
+
+int main(int ac, char **av)
+{
+    const char *rom = NULL;
+    uint32_t max_frames = 0;
+    const char *movie_play = NULL;
+    const char *load_state_path = NULL;
+    const char *save_state_path = NULL;
+    bool start_game = false;
+    const char *fork_server = NULL;
+    const char *fork_client = NULL;
+    const char *fork_request = "RUN 600";
+    int fork_count = 1;
+    const char *session_record = NULL;
+    int session_interval = SESSION_DEFAULT_INTERVAL;
+    const char *session_play = NULL;
+    long seek = -1;
+    bool verify = false;
+    const char *stream_view = NULL;
+    long stream_input = -1;
+
+    for (int i = 1; i < ac; i++)
+    {
+        if (strcmp(av[i], "--frames") == 0 && i + 1 < ac)
+            max_frames = (uint32_t)strtoul(av[++i], NULL, 10);
+        else if (strcmp(av[i], "--movie-play") == 0 && i + 1 < ac)
+            movie_play = av[++i];
+        else if (strcmp(av[i], "--load-state") == 0 && i + 1 < ac)
+            load_state_path = av[++i];
+        else if (strcmp(av[i], "--save-state") == 0 && i + 1 < ac)
+            save_state_path = av[++i];
+        else if (strcmp(av[i], "--session-record") == 0 && i + 1 < ac)
+            session_record = av[++i];
+        else if (strcmp(av[i], "--session-interval") == 0 && i + 1 < ac)
+            session_interval = atoi(av[++i]);
+        else if (strcmp(av[i], "--session-play") == 0 && i + 1 < ac)
+            session_play = av[++i];
+        else if (strcmp(av[i], "--seek") == 0 && i + 1 < ac)
+            seek = atol(av[++i]);
+        else if (strcmp(av[i], "--verify") == 0)
+            verify = true;
+        else if (strcmp(av[i], "--stream-view") == 0 && i + 1 < ac)
+            stream_view = av[++i];
+        else if (strcmp(av[i], "--stream-input") == 0 && i + 1 < ac)
+            stream_input = strtol(av[++i], NULL, 16) & 0xFF;
+        else if (strcmp(av[i], "--start-game") == 0)
+            start_game = true;
+        else if (strcmp(av[i], "--fork-server") == 0 && i + 1 < ac)
+            fork_server = av[++i];
+        else if (strcmp(av[i], "--fork-client") == 0 && i + 1 < ac)
+            fork_client = av[++i];
+        else if (strcmp(av[i], "--fork-request") == 0 && i + 1 < ac)
+            fork_request = av[++i];
+        else if (strcmp(av[i], "--fork-count") == 0 && i + 1 < ac)
+            fork_count = atoi(av[++i]);
+        else
+            rom = av[i];
+    }
+    // Client du fork server : ni ROM ni machine de ce côté
+    if (fork_client)
+        return run_fork_client(fork_client, fork_request, fork_count) == 0 ? 0 : 1;
+    if (stream_view)
+        return view_stream(stream_view, max_frames, stream_input) == 0 ? 0 : 1;
+    if (!rom || (!max_frames && !movie_play && !fork_server && !session_play))
+    {
+        printf("ERR: You need to specify the rom and a length ex: ./bin/emu_headless [--frames n] [--movie-play file] [--load-state file] [--save-state file] [--start-game] [--session-record file] [--session-interval n] [--session-play file [--seek frame] [--verify]] [--fork-server socket] [--fork-client socket --fork-request \"RUN frames port1xn ...\" --fork-count n] [--stream-view socket [--stream-input port1hex]] rom/invaders.rom\n");
+        return 0;
+    }
+    if (i8080_api_version() != I8080_API_VERSION)
+    {
+        printf("ERR: libi8080 API version %d, expected %d\n", i8080_api_version(), I8080_API_VERSION);
+        return 1;
+    }
+
+    I8080_Machine *m = i8080_create();
+    size_t state_size = i8080_state_size();
+    uint8_t *state = malloc(state_size);
+    if (!m || !state || i8080_load_rom(m, rom) != 0)
+        return 1;
+    i8080_set_frame_callback(m, count_frame, NULL);
+
+    if (load_state_path)
+    {
+        FILE *f = fopen(load_state_path, "rb");
+        size_t got = f ? fread(state, 1, state_size, f) : 0;
+        if (f)
+            fclose(f);
+        if (i8080_load_state(m, state, got) != 0)
+        {
+            printf("ERR: %s is not a save state for this ROM and version\n", load_state_path);
+            return 1;
+        }
+    }
+    if (start_game && invaders_start_game(m) != 0)
+    {
+        printf("ERR: the game did not start, is %s a Space Invaders ROM?\n", rom);
+        return 1;
+    }
+    // --frames se compte à partir du début de la partie, pas de la mise sous tension
+    frame_number = 0;
+    bool per_interrupt = false;
+    if (movie_play && start_movie_play(movie_play, &per_interrupt) != 0)
+    {
+        printf("ERR: could not play movie %s\n", movie_play);
+        return 1;
+    }
+    // run_frame ne s'arrête qu'au VBlank : les films lus à chaque interrupt passent par emu
+    if (per_interrupt)
+    {
+        printf("ERR: %s reads inputs at every interrupt, only per-frame movies can be played here\n", movie_play);
+        return 1;
+    }
+
+    if (session_record && start_session_record(session_record, session_interval) != 0)
+    {
+        printf("ERR: could not record session to %s\n", session_record);
+        return 1;
+    }
+    if (session_play && play_session(m, session_play, seek, verify) != 0)
+        return 1;
+
+    uint64_t start_cyc = i8080_get_cycles(m);
+    clock_t t0 = clock();
+    while (max_frames || movie_play)
+    {
+        i8080_run_frame(m);
+        // Entrées lues au VBlank, comme la boucle d'emu
+        uint8_t ports[2] = { 0, 0 };
+        movie_latch(ports);
+        i8080_set_inputs(m, ports[0], ports[1]);
+        session_latch(m, ports[0], ports[1]);
+        if (max_frames && frame_number >= max_frames)
+            break;
+        if (movie_finished())
+            break;
+    }
+    double seconds = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    uint64_t cyc = i8080_get_cycles(m);
+    bool ran = max_frames || movie_play; // Sinon la machine sort d'un seek ou part au fork server
+
+    if (ran && seconds > 0)
+        printf("Headless: %u frames in %.2f s, %.0f fps (%.1fx real time)\n", frame_number, seconds,
+            frame_number / seconds, (double)(cyc - start_cyc) / I8080_CLOCK / seconds);
+    if (session_record)
+    {
+        Session_Stats rstats;
+        stop_session_record();
+        get_session_stats(&rstats, NULL);
+        printf("Session record: %u frames, %u checkpoints, %llu bytes\n", rstats.frames, rstats.checkpoints,
+            (unsigned long long)rstats.bytes);
+    }
+    if (movie_play)
+    {
+        stop_movie();
+        printf("Movie: frame %u at cycle %llu, VRAM hash %016llx\n", frame_number,
+            (unsigned long long)cyc, (unsigned long long)i8080_frame_hash(m));
+    }
+    else if (ran)
+        printf("Headless: frame %u at cycle %llu, VRAM hash %016llx\n", frame_number,
+            (unsigned long long)cyc, (unsigned long long)i8080_frame_hash(m));
+    if (save_state_path)
+    {
+        FILE *f = fopen(save_state_path, "wb");
+        if (!f || i8080_save_state(m, state, state_size) != 0 || fwrite(state, state_size, 1, f) != 1)
+            printf("ERR: could not save state to %s\n", save_state_path);
+        if (f)
+            fclose(f);
+    }
+    // Chauffée jusqu'ici, la machine ne sert plus qu'à être forkée
+    int ret = fork_server ? run_fork_server(m, fork_server) : 0;
+    free(state);
+    i8080_destroy(m);
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#include "../includes/i8080.h"
+#include "../includes/cpu8080.h"
+#include "../includes/memory.h"
+#include "../includes/io.h"
+#include "../includes/snapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Interface publique de libi8080 : de fines enveloppes autour du cœur. Une
+machine est une structure CPU allouée sur le tas ; chaque hook (frame, son,
+ports inconnus) reçoit le pointeur user posé avec lui.
+Les sauvegardes sont le Save_State de snapshot.c, en-tête versionné compris.
+*/
+
+int i8080_api_version()
+{
+    return I8080_API_VERSION;
+}
+
+I8080_Machine *i8080_create()
+{
+    CPU *cpu = malloc(sizeof(CPU));
+
+    if (!cpu)
+        return NULL;
+    init_cpu(cpu);
+    return cpu;
+}
+
+void i8080_destroy(I8080_Machine *m)
+{
+    free(m);
+}
+
+int i8080_load_rom(I8080_Machine *m, const char *path)
+{
+    return load_rom(m, path);
+}
+
+int i8080_load_rom_data(I8080_Machine *m, const uint8_t *data, size_t size)
+{
+    return load_rom_data(m, data, size);
+}
+
+void i8080_reset(I8080_Machine *m)
+{
+    reset_cpu(m);
+}
+
+// Lues par le jeu jusqu'au prochain appel : une fois par frame suffit
+void i8080_set_inputs(I8080_Machine *m, uint8_t port1, uint8_t port2)
+{
+    set_inputs(m, port1, port2);
+}
+
+// Émule jusqu'au VBlank suivant (1/60 s de la borne)
+void i8080_run_frame(I8080_Machine *m)
+{
+    while (run_emu(m) != EMU_END_FRAME)
+        ;
+}
+
+const uint8_t *i8080_get_frame(const I8080_Machine *m)
+{
+    return get_vram(m);
+}
+
+uint64_t i8080_frame_hash(const I8080_Machine *m)
+{
+    return hash_vram(get_vram(m));
+}
+
+static uint64_t fnv_mix(uint64_t hash, const uint8_t *p, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ p[i]) * 0x100000001B3ull;
+    return hash;
+}
+
+// Toute la machine (registres, horloge, ports, RAM, VRAM), champ par champ :
+// le remplissage des structures n'y entre pas, deux machines identiques ont le même hash
+uint64_t i8080_state_hash(const I8080_Machine *m)
+{
+    uint8_t regs[] = { m->a, m->b, m->c, m->d, m->e, m->h, m->l, m->pc & 0xFF, m->pc >> 8,
+        m->sp & 0xFF, m->sp >> 8, get_f_flags(m), m->halted, m->interrupt_enable,
+        m->interrupt_pending, m->ei_pending, m->interrupt_vector,
+        m->io.bits_reg & 0xFF, m->io.bits_reg >> 8, m->io.shift_amount,
+        m->io.latched[0], m->io.latched[1], m->io.sound[0], m->io.sound[1] };
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    hash = fnv_mix(hash, regs, sizeof(regs));
+    hash = fnv_mix(hash, (const uint8_t *)&m->clock.totcyc, sizeof(m->clock.totcyc));
+    for (uint32_t i = 0; i < m->clock.sched.count; i++)
+    {
+        uint64_t ev[2] = { m->clock.sched.heap[i].at, m->clock.sched.heap[i].id };
+        hash = fnv_mix(hash, (const uint8_t *)ev, sizeof(ev));
+    }
+    hash = fnv_mix(hash, m->memory + RAM_START, RAM_SIZE);
+    return hash ^ hash_vram(get_vram(m));
+}
+
+uint64_t i8080_get_cycles(const I8080_Machine *m)
+{
+    return get_cyc(m);
+}
+
+// Lecture seule, avec la carte mémoire de la borne (RAM de jeu : 0x2000-0x23FF)
+uint8_t i8080_peek(const I8080_Machine *m, uint16_t addr)
+{
+    return read_memory(m, addr);
+}
+
+size_t i8080_state_size()
+{
+    return sizeof(Save_State);
+}
+
+// buf n'a pas à être aligné : l'état passe par une copie locale
+int i8080_save_state(const I8080_Machine *m, void *buf, size_t size)
+{
+    Save_State state;
+
+    if (size < sizeof(state))
+        return -1;
+    memset(&state, 0, sizeof(state)); // Octets de remplissage compris : même état, même sauvegarde
+    save_state(m, &state);
+    memcpy(buf, &state, sizeof(state));
+    return 0;
+}
+
+int i8080_load_state(I8080_Machine *m, const void *buf, size_t size)
+{
+    Save_State state;
+
+    if (size < sizeof(state))
+        return -1;
+    memcpy(&state, buf, sizeof(state));
+    return load_state(m, &state);
+}
+
+void i8080_set_frame_callback(I8080_Machine *m, I8080_Frame_Fn fn, void *user)
+{
+    m->hooks.frame = fn;
+    m->hooks.frame_user = user;
+}
+
+void i8080_set_sound_callback(I8080_Machine *m, I8080_Sound_Fn fn, void *user)
+{
+    m->hooks.sound = fn;
+    m->hooks.sound_user = user;
+}
+
+void i8080_set_out_callback(I8080_Machine *m, I8080_Out_Fn fn, void *user)
+{
+    m->hooks.out = fn;
+    m->hooks.out_user = user;
+}
@@ -1,112 +1,73 @@
-#include "includes/i8080_test.h"
-#include "includes/cpu8080.h"
-#include "includes/memory.h"
-#include "includes/utils.h"
+#include "../includes/cpu8080.h"
+#include "../includes/memory.h"
 
 #include <stdio.h>
 #include <string.h>
 
-static bool test_finished = false;
-static int nb_instr = 0;
+/*
+Lanceur des ROM de test CP/M (TST8080, 8080PRE, CPUTEST, 8080EXM) sur le même
+cœur que l'émulateur. La machine passe en mémoire plate, le programme est
+chargé en 0x100 et deux instructions remplacent le système :
+ - 0x0000 : OUT 0 (le programme rend la main : fin du test)
+ - 0x0005 : OUT 1 puis RET (appel BDOS : C = 2 affiche E, C = 9 la chaîne en DE jusqu'à '$')
+*/
 
-int get_nb_intr()
-{
-    return nb_instr;
-}
+static bool test_finished = false;
 
-uint8_t load_rom_test(CPU *cpu, char *filename)
+static int load_com(CPU *cpu, const char *path)
 {
-    FILE *rom = fopen(filename, "rb");
-    if(!rom)
+    FILE *com = fopen(path, "rb");
+    if (!com)
     {
         perror("Error fopen:");
         return -1;
     }
-    fread(&cpu->memory[0x100], sizeof(uint8_t) * (0x4B00), 1, rom); // Mettre la bonne taille
-    fclose(rom);
+    fread(&cpu->memory[0x100], 1, sizeof(cpu->memory) - 0x100, com);
+    fclose(com);
     return 0;
 }
 
-void init_cpu_test(CPU *cpu)
+static void bdos(void *user, uint8_t port, uint8_t value)
 {
-    cpu->pc = 0x0100;
-    cpu->sp = 0x0000;
-    memset(cpu->memory, 0, sizeof(cpu->memory));
-
-    cpu->a = 0;
-    cpu->b = 0;
-    cpu->c = 0;
-    cpu->d = 0;
-    cpu->e = 0;
-    cpu->h = 0;
-    cpu->l = 0;
-
-    cpu->z = 0;
-    cpu->c = 0;
-    cpu->ac = 0;
-    cpu->p = 0;
-    cpu->s = 0;
+    CPU *cpu = user;
 
-    cpu->halted = false;
-    cpu->interrupt_enable = false;
+    (void)value;
+    if (port == 0)
+        test_finished = true;
+    else if (port == 1 && cpu->c == 2)
+        putchar(cpu->e);
+    else if (port == 1 && cpu->c == 9)
+    {
+        for (uint16_t addr = (cpu->d << 8) | cpu->e; read_memory(cpu, addr) != '$'; addr++)
+            putchar(read_memory(cpu, addr));
+    }
+    fflush(stdout);
 }
 
-void finish_exec()
+int main(int ac, char **av)
 {
-    test_finished = true;
-}
+    static CPU cpu;
 
-void print_opcode(CPU *cpu, int cyc)
-{
-    uint8_t opcode = cpu->memory[cpu->pc];
-    printf("PC: %04X, AF: %02X%02X, BC: %02X%02X, DE: %02X%02X, HL: %02X%02X, SP: %04X, CYC: %d (%02X %02X %02X %02X)\n", 
-        cpu->pc, cpu->a, get_f_flags(cpu) ,cpu->b, cpu->c, cpu->d, cpu->e,
-        cpu->h, cpu->l, cpu->sp, cyc,read_memory(cpu, cpu->pc), read_memory(cpu, cpu->pc+1), read_memory(cpu, cpu->pc+2), 
-        read_memory(cpu, cpu->pc+3));
-}
-
-int main(void)
-{
-    CPU cpu;
-    init_cpu_test(&cpu);
-    // load_rom_test(&cpu, "rom/test_rom/8080PRE.COM");
-    load_rom_test(&cpu, "rom/test_rom/8080EXM.COM");
-    
-    // inject "out 0,a" at 0x0000 (signal to stop the test)
-    cpu.memory[0x0000] = 0xD3;
+    if (ac < 2)
+    {
+        printf("ERR: You need to specify the test rom ex: ./bin/i8080_test rom/test_rom/TST8080.COM\n");
+        return 0;
+    }
+    init_cpu(&cpu);
+    cpu.flat_memory = true;
+    if (load_com(&cpu, av[1]) != 0)
+        return 1;
+    cpu.pc = 0x0100;
+    cpu.memory[0x0000] = 0xD3; // OUT 0
     cpu.memory[0x0001] = 0x00;
-
-    // inject "out 1,a" at 0x0005 (signal to output some characters)
-    cpu.memory[0x0005] = 0xD3;
+    cpu.memory[0x0005] = 0xD3; // OUT 1
     cpu.memory[0x0006] = 0x01;
-    cpu.memory[0x0007] = 0xC9;
+    cpu.memory[0x0007] = 0xC9; // RET
+    cpu.hooks.out = bdos;
+    cpu.hooks.out_user = &cpu;
 
-    // Test for debug SUB flag F
-    /*cpu.memory[0x0100] = 0x3A; // LDA A, a16
-    cpu.memory[0x0101] = 0x90;
-    cpu.memory[0x0102] = 0x00;
-    cpu.memory[0x0103] = 0x06; // MVI B, d8
-    cpu.memory[0x0104] = 0x16;
-    cpu.memory[0x0105] = 0xB8; // CMP B
-    cpu.memory[0x0106] = 0xCD; // CALL (EXIT)
-    cpu.memory[0x0107] = 0x00;
-    cpu.memory[0x0108] = 0x00; 
-
-    // Test number
-    cpu.memory[0x0090] = 0x06; // For A
-    cpu.memory[0x0091] = 0x01;*/
-
-    int cyc = 0;
     while (!test_finished)
-    {
-        if (nb_instr == 2919050698)
-            test_finished = 1;
-        if (nb_instr > 210538394)
-            print_opcode(&cpu, cyc);
-        cyc += step_emu(&cpu);
-        nb_instr++;
-        // printf("%d\n", cyc);
-    }
-    printf("%d instructions executed on %d cycles\n", nb_instr, cyc);
+        step_emu(&cpu);
+    printf("\n%llu cycles\n", (unsigned long long)get_cyc(&cpu));
     return 0;
-}
\ No newline at end of file
+}
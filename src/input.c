@@ -0,0 +1,102 @@
+#include "../includes/input.h"
+#include "../includes/movie.h"
+
+/*
+Les touches de l'hôte ne modifient que l'état en attente ; latch_inputs() le
+pose dans la machine (set_inputs), une fois par frame (ou par interrupt). Le
+jeu voit donc des entrées stables entre deux points de lecture, et un film
+(movie.c) peut les enregistrer ou les remplacer à ces mêmes points.
+Un octet par port, avec les bits du port : pending[0] = port 1, pending[1] = port 2.
+*/
+static uint8_t pending[2];
+static uint8_t remote[2]; // Entrées des viewers du stream, ajoutées à celles du clavier
+
+// Joueur automatique (--input-bot) : de quoi lancer une partie sans clavier ni film
+#define BOT_COIN_1 60
+#define BOT_COIN_2 90
+#define BOT_START 150
+#define BOT_PRESS 10 // Frames d'appui sur une pièce ou un start
+static uint32_t bot_rng = 0; // 0 : pas de bot
+static uint32_t bot_latches = 0;
+static uint32_t bot_hold = 0;
+static uint8_t bot_ports[2];
+
+void keyboard_to_io(IO_Def iod, uint8_t value)
+{
+    uint8_t mask[2] = { 0, 0 };
+
+    get_io_mask(iod, mask);
+    for (int i = 0; i < 2; i++)
+    {
+        if (value)
+            pending[i] |= mask[i];
+        else
+            pending[i] &= ~mask[i];
+    }
+}
+
+// Même graine, mêmes entrées : deux pièces, le start 2 joueurs, puis gauche,
+// droite et tir au hasard pour les deux joueurs. En netplay, chaque machine ne
+// garde que les bits de son joueur
+void set_input_bot(uint32_t seed)
+{
+    bot_rng = seed ? seed : 0x2545F491;
+    bot_latches = 0;
+    bot_hold = 0;
+}
+
+static void bot_inputs(uint8_t ports[2])
+{
+    uint32_t n = bot_latches++;
+
+    if (n >= BOT_COIN_1 && n < BOT_COIN_1 + BOT_PRESS)
+        get_io_mask(COIN, ports);
+    else if (n >= BOT_COIN_2 && n < BOT_COIN_2 + BOT_PRESS)
+        get_io_mask(COIN, ports);
+    else if (n >= BOT_START && n < BOT_START + BOT_PRESS)
+        get_io_mask(TWO_P_START, ports);
+    if (n < BOT_START + BOT_PRESS)
+        return;
+    // Une action tenue 8 à 31 frames
+    if (!bot_hold)
+    {
+        bot_rng ^= bot_rng << 13;
+        bot_rng ^= bot_rng >> 17;
+        bot_rng ^= bot_rng << 5;
+        bot_hold = 8 + bot_rng % 24;
+        bot_ports[0] = bot_ports[1] = 0;
+        if (bot_rng & 0x100)
+            get_io_mask((bot_rng & 0x200) ? ONE_P_LEFT : ONE_P_RIGHT, bot_ports);
+        if (bot_rng & 0x400)
+            get_io_mask(ONE_P_SHOOT, bot_ports);
+        if (bot_rng & 0x800)
+            get_io_mask((bot_rng & 0x1000) ? TWO_P_LEFT : TWO_P_RIGHT, bot_ports);
+        if (bot_rng & 0x2000)
+            get_io_mask(TWO_P_SHOOT, bot_ports);
+    }
+    bot_hold--;
+    ports[0] |= bot_ports[0];
+    ports[1] |= bot_ports[1];
+}
+
+void latch_inputs(CPU *cpu)
+{
+    uint8_t ports[2] = { pending[0] | remote[0], pending[1] | remote[1] };
+
+    if (bot_rng)
+        bot_inputs(ports);
+    movie_latch(ports);
+    set_inputs(cpu, ports[0], ports[1]);
+}
+
+void set_remote_inputs(const uint8_t ports[2])
+{
+    remote[0] = ports[0];
+    remote[1] = ports[1];
+}
+
+void get_pending_inputs(uint8_t ports[2])
+{
+    ports[0] = pending[0];
+    ports[1] = pending[1];
+}
@@ -0,0 +1,52 @@
+#include "../includes/invaders.h"
+
+/*
+Ce que les outils (environnement vectorisé, fork server) savent du jeu
+lui-même : où lire le score et l'état de la partie, et comment en lancer une.
+*/
+
+#define BOOT_FRAMES 120      // Fin du test mémoire et de l'écran d'accueil
+#define PRESS_FRAMES 5
+#define START_TIMEOUT 600
+
+uint32_t invaders_score(const I8080_Machine *m)
+{
+    uint8_t lo = i8080_peek(m, RAM_SCORE_L);
+    uint8_t hi = i8080_peek(m, RAM_SCORE_M);
+
+    return (hi >> 4) * 1000 + (hi & 0xF) * 100 + (lo >> 4) * 10 + (lo & 0xF);
+}
+
+uint8_t invaders_ships(const I8080_Machine *m)
+{
+    return i8080_peek(m, RAM_SHIPS);
+}
+
+bool invaders_playing(const I8080_Machine *m)
+{
+    return i8080_peek(m, RAM_GAME_MODE) != 0;
+}
+
+static void run_frames(I8080_Machine *m, uint8_t port1, int n)
+{
+    i8080_set_inputs(m, port1, 0);
+    for (int i = 0; i < n; i++)
+        i8080_run_frame(m);
+}
+
+// Démarrage, pièce, 1P START, jusqu'à ce que la partie tourne. Le jeu passe
+// en mode partie avant d'écrire le nombre de vaisseaux : on attend les deux
+int invaders_start_game(I8080_Machine *m)
+{
+    run_frames(m, 0, BOOT_FRAMES);
+    run_frames(m, I8080_COIN, PRESS_FRAMES);
+    run_frames(m, 0, 30);
+    run_frames(m, I8080_P1_START, PRESS_FRAMES);
+    for (int i = 0; i < START_TIMEOUT; i++)
+    {
+        if (invaders_playing(m) && invaders_ships(m) != 0)
+            return 0;
+        run_frames(m, 0, 1);
+    }
+    return -1;
+}
@@ -1,9 +1,5 @@
 #include "../includes/io.h"
 #include "../includes/cpu8080.h"
-#include "../includes/memory.h"
-#include "../includes/video.h"
-
-#include <stdio.h>
 
 
 /*
@@ -43,120 +39,82 @@ Port 3
  */
 
 
-static uint16_t bits_reg;
-static uint8_t shift_amount;
-
-// Port 1
-static uint8_t is_coin;
-static uint8_t is_one_p_shoot;
-static uint8_t is_one_p_left;
-static uint8_t is_one_p_right;
-static uint8_t is_one_p_start;
-static uint8_t is_two_p_start;
-
-static uint8_t is_two_p_shoot;
-static uint8_t is_two_p_left;
-static uint8_t is_two_p_right;
-// Port 2
+/*
+Registres de la borne dans cpu->io : registre à décalage, entrées figées et
+derniers octets envoyés au son. Les entrées sont posées de l'extérieur par
+set_inputs() (une fois par frame, ou par interrupt) : le jeu les voit stables
+entre deux points de lecture. Un octet par port, avec les bits du port :
+latched[0] = port 1, latched[1] = port 2.
+*/
 
+static const struct { uint8_t port; uint8_t bit; } io_bits[] = {
+    [COIN]        = { 0, 0 }, // Keyboard C
+    [ONE_P_SHOOT] = { 0, 4 }, // Keyboard Z
+    [ONE_P_LEFT]  = { 0, 5 }, // Keyboard Q
+    [ONE_P_RIGHT] = { 0, 6 }, // Keyboard D
+    [ONE_P_START] = { 0, 2 }, // Keyboard R
+    [TWO_P_START] = { 0, 1 }, // Keyboard T
+    [TWO_P_SHOOT] = { 1, 4 }, // Keyboard Space
+    [TWO_P_LEFT]  = { 1, 5 }, // Keyboard <
+    [TWO_P_RIGHT] = { 1, 6 }, // Keyboard >
+};
 
-void keyboard_to_io(IO_Def iod, uint8_t value)
+// Ajoute à mask le bit de l'entrée iod (mask[0] = port 1, mask[1] = port 2)
+void get_io_mask(IO_Def iod, uint8_t mask[2])
 {
-    switch (iod)
-    {
-    case COIN: // Keyboard C
-        is_coin = value;
-        break;
-    case ONE_P_SHOOT: // Keyboard  Z
-        is_one_p_shoot = value; 
-        break;
-    case ONE_P_LEFT: // Keyboard Q
-        is_one_p_left = value;
-        break;
-    case ONE_P_RIGHT: // Keyboard D
-        is_one_p_right = value;
-        break;
-    case ONE_P_START: // Keyboard R
-        is_one_p_start = value;
-        break;
-    case TWO_P_START: // Keyboard T
-        is_two_p_start = value;
-        break;
+    if ((unsigned)iod < sizeof(io_bits) / sizeof(io_bits[0]))
+        mask[io_bits[iod].port] |= 1 << io_bits[iod].bit;
+}
 
-    case TWO_P_SHOOT: // Keyboard  Space
-        is_two_p_shoot = value; 
-        break;
-    case TWO_P_LEFT: // Keyboard <
-        is_two_p_left = value;
-        break;
-    case TWO_P_RIGHT: // Keyboard >
-        is_two_p_right = value;
-        break;
-    default:
-        break;
-    }
-    // SDL_Log("ONE_P_SHOOT: %d\n", is_one_p_shoot);
+void set_inputs(CPU *cpu, uint8_t port1, uint8_t port2)
+{
+    cpu->io.latched[0] = port1;
+    cpu->io.latched[1] = port2;
 }
 
-void write_io(CPU cpu, uint8_t port, uint8_t value)
+void write_io(CPU *cpu, uint8_t port, uint8_t value)
 {
     switch (port)
     {
-    /*case 0x00:
-        // finish_exec();
-        return;
-    case 0x01:
-        if (cpu.c == 2)
-        {
-            printf("%c", cpu.e);
-        }
-        if (cpu.c == 9)
-        {
-            uint16_t addr = (cpu.d << 8) | cpu.e;
-            uint16_t i = 0;
-            uint8_t buff[256] = {0};
-            while (read_memory(&cpu, addr+i) != '$')
-            {
-                buff[i] = read_memory(&cpu, addr+i);
-                i++;
-            }
-            buff[i] = '\0';
-            i = 0;
-            // printf("ligne: %d lettre:\"", get_nb_intr());
-            while (buff[i])
-            {
-                printf("%c", buff[i++]);
-                printf("%c", value);
-            }
-            // printf("\"");
-        }*/
-
         case 2:
-            shift_amount = value & 7;
+            cpu->io.shift_amount = value & 7;
             return;
+        case 3:
+        case 5:
+        {
+            // Seuls les changements intéressent le son
+            uint8_t *last = &cpu->io.sound[port == 3 ? 0 : 1];
+            if (*last == value)
+                return;
+            *last = value;
+            if (cpu->hooks.sound)
+                cpu->hooks.sound(cpu->hooks.sound_user, port, value, cpu->clock.totcyc);
+            return;
+        }
         case 4:
-            bits_reg = (value << 8) | (bits_reg >> 8);
+            cpu->io.bits_reg = (value << 8) | (cpu->io.bits_reg >> 8);
             return;
     default:
         break;
     }
-    return;
+    if (cpu->hooks.out)
+        cpu->hooks.out(cpu->hooks.out_user, port, value);
 }
 
-uint8_t read_io(uint8_t port)
+uint8_t read_io(CPU *cpu, uint8_t port)
 {
     switch (port)
     {
         case 0:
             return 0x0F;
         case 1:
-            return (0 << 7) | (is_one_p_right << 6) | (is_one_p_left << 5) | (is_one_p_shoot << 4 ) | (1 << 3) | (is_one_p_start << 2) | (is_two_p_start << 1) | is_coin;
+            return cpu->io.latched[0] | (1 << 3);
         case 2:
-            return (0 << 7) | (is_two_p_right << 6) | (is_two_p_left << 5) | (is_two_p_shoot << 4) | (1 << 3) | (0 << 2) | (0 << 1) | 0;
+            return cpu->io.latched[1] | (1 << 3);
         case 3:
-            return (bits_reg >> shift_amount) & 0xFF;
+            return (cpu->io.bits_reg >> cpu->io.shift_amount) & 0xFF;
     default:
         break;
     }
     return 0;
-}
\ No newline at end of file
+}
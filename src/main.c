@@ -1,9 +1,33 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "../includes/cpu8080.h"
 #include "../includes/memory.h"
 #include "../includes/video.h"
 #include "../includes/io.h"
+#include "../includes/input.h"
+#include "../includes/overlay.h"
+#include "../includes/filter.h"
+#include "../includes/frame.h"
+#include "../includes/recorder.h"
+#include "../includes/pacer.h"
+#include "../includes/sound.h"
+#include "../includes/wav.h"
+#include "../includes/movie.h"
+#include "../includes/runahead.h"
+#include "../includes/snapshot.h"
+#include "../includes/rewind.h"
+#include "../includes/netplay.h"
+#include "../includes/vecenv.h"
+#include "../includes/pool.h"
+#include "../includes/session.h"
+#include "../includes/stream.h"
+#include "../includes/obs.h"
+
+// Touches de sauvegarde, traitées entre deux frames par la boucle principale
+static enum { STATE_NONE, STATE_SAVE, STATE_LOAD } state_request = STATE_NONE;
+static bool rewinding = false; // Retour arrière tant que la touche est enfoncée
+static bool turbo_toggle = false;
 
 void update_input_keyboard(SDL_Event* e)
 {
@@ -33,6 +57,18 @@ void update_input_keyboard(SDL_Event* e)
                 case SDLK_SPACE:
                     keyboard_to_io(TWO_P_SHOOT, 1);
                     break;
+                case SDLK_F5:
+                    state_request = STATE_SAVE;
+                    break;
+                case SDLK_F9:
+                    state_request = STATE_LOAD;
+                    break;
+                case SDLK_BACKSPACE:
+                    rewinding = true;
+                    break;
+                case SDLK_TAB:
+                    turbo_toggle = true;
+                    break;
                 case SDLK_LEFT:
                     keyboard_to_io(TWO_P_LEFT, 1);
                     break;
@@ -75,6 +111,9 @@ void update_input_keyboard(SDL_Event* e)
                 case SDLK_RIGHT:
                     keyboard_to_io(TWO_P_RIGHT, 0);
                     break;
+                case SDLK_BACKSPACE:
+                    rewinding = false;
+                    break;
                 default:
                     break;
             }
@@ -82,6 +121,222 @@ void update_input_keyboard(SDL_Event* e)
     }
 }
 
+// Vide la file d'événements SDL puis fige l'état des touches pour le jeu
+// Renvoie false si l'utilisateur a demandé à quitter
+bool poll_input(CPU *cpu, bool has_window)
+{
+    SDL_Event e;
+    bool play = true;
+
+    while (has_window && SDL_PollEvent(&e))
+    {
+        if (e.type == SDL_EVENT_QUIT) play = false;
+        else if (e.type == SDL_EVENT_KEY_DOWN && e.key.key == SDLK_ESCAPE) play = false;
+        else update_input_keyboard(&e);
+    }
+    latch_inputs(cpu);
+    return play;
+}
+
+// Le turbo court-circuite tout ce qui rythme l'émulation : pacer, vsync, son
+static void apply_turbo(bool on, Pacing_Mode pacing_mode)
+{
+    set_turbo(on);
+    set_vsync(!on && pacing_mode == PACING_VSYNC);
+    set_sound_muted(on);
+}
+
+// Dans le titre de la fenêtre, ou sur la sortie en headless quand le turbo tourne
+static void show_speed(bool has_window)
+{
+    Pacer_Speed speed;
+    char title[128];
+
+    if (!get_pacer_speed(&speed))
+        return;
+    snprintf(title, sizeof(title), "%s - %.2fx (%.2f MHz, %.0f fps)%s", WINDOW_TITLE,
+        speed.factor, speed.mhz, speed.fps, get_turbo() ? " turbo" : "");
+    if (has_window)
+        set_window_title(title);
+    else if (get_turbo())
+        printf("Speed: %.2fx (%.2f MHz), %.0f fps\n", speed.factor, speed.mhz, speed.fps);
+}
+
+// Hooks de la machine : la VRAM part vers les consommateurs de frames, les ports de son vers le mixage
+static void on_frame(void *user, const uint8_t *vram, uint64_t cyc)
+{
+    (void)user;
+    submit_frame(vram, cyc);
+}
+
+static void on_sound(void *user, uint8_t port, uint8_t value, uint64_t cyc)
+{
+    (void)user;
+    sound_write(port, value, cyc);
+}
+
+static void stream_consumer(const Frame *frame, void *user)
+{
+    (void)user;
+    stream_frame(frame->vram, frame->number, frame->cyc, frame->hash, frame->changed);
+}
+
+// --obs-check : les observations de chaque frame sont comparées à la conversion ARGB
+#define OBS_CHECK_POOL 84
+static uint32_t obs_checked = 0;
+static uint32_t obs_mismatches = 0;
+
+static void obs_check_consumer(const Frame *frame, void *user)
+{
+    static uint32_t argb[W * H];
+    static uint8_t gray[OBS_GRAY_SIZE];
+    static uint8_t full[OBS_GRAY_SIZE];
+    uint8_t packed[OBS_PACKED_SIZE];
+    uint8_t pooled[OBS_CHECK_POOL * OBS_CHECK_POOL];
+    bool ok = true;
+
+    (void)user;
+    frame_to_argb(frame, argb);
+    obs_gray(frame->vram, gray);
+    obs_packed(frame->vram, packed);
+    // Pleine taille, le max-pooling ne doit rien changer
+    obs_pooled(frame->vram, full, OBS_W, OBS_H);
+    obs_pooled(frame->vram, pooled, OBS_CHECK_POOL, OBS_CHECK_POOL);
+    for (int p = 0; p < OBS_GRAY_SIZE && ok; p++)
+    {
+        // Pixel éteint = noir opaque, quel que soit l'overlay
+        uint8_t lit = argb[p] != 0xFF000000u ? 255 : 0;
+        uint8_t bit = ((packed[p / 8] >> (7 - p % 8)) & 1) ? 255 : 0;
+        ok = gray[p] == lit && bit == lit && full[p] == lit;
+    }
+    // Réduction : maximum de la zone source, pixel par pixel
+    for (int oy = 0; oy < OBS_CHECK_POOL && ok; oy++)
+    {
+        for (int ox = 0; ox < OBS_CHECK_POOL && ok; ox++)
+        {
+            uint8_t v = 0;
+            for (int y = oy * H / OBS_CHECK_POOL; y < ((oy + 1) * H + OBS_CHECK_POOL - 1) / OBS_CHECK_POOL; y++)
+                for (int x = ox * W / OBS_CHECK_POOL; x < ((ox + 1) * W + OBS_CHECK_POOL - 1) / OBS_CHECK_POOL; x++)
+                    if (argb[y * W + x] != 0xFF000000u)
+                        v = 255;
+            ok = pooled[oy * OBS_CHECK_POOL + ox] == v;
+        }
+    }
+    obs_checked++;
+    if (!ok)
+        obs_mismatches++;
+}
+
+// Viewer d'un emu lancé avec --stream : affiche ses frames et lui renvoie le clavier
+static int run_stream_view(const char *path, const char *video, const char *overlay, uint32_t max_frames)
+{
+    uint8_t vram[VRAM_SIZE];
+    uint8_t sent[2] = { 0, 0 };
+    Stream_Info info;
+    Stream_Stats vstats;
+    uint32_t frames = 0;
+    bool play = true;
+    int got = 0;
+
+    if (load_overlay(overlay) != 0)
+        printf("ERR: overlay %s could not be loaded, using mono\n", overlay);
+    if (init_video(video) != 0)
+        return 1;
+    if (stream_attach(path) != 0)
+    {
+        printf("ERR: could not attach to stream %s\n", path);
+        quit_video();
+        return 1;
+    }
+    bool has_window = get_video_backend()->has_window;
+    while (play && (got = stream_next_frame(vram, &info)) >= 0)
+    {
+        SDL_Event e;
+        uint8_t ports[2];
+
+        if (got)
+        {
+            present_frame(vram, info.cyc);
+            frames++;
+        }
+        else
+            SDL_Delay(1);
+        while (has_window && SDL_PollEvent(&e))
+        {
+            if (e.type == SDL_EVENT_QUIT) play = false;
+            else if (e.type == SDL_EVENT_KEY_DOWN && e.key.key == SDLK_ESCAPE) play = false;
+            else update_input_keyboard(&e);
+        }
+        // Seulement les changements : l'émulateur garde le dernier état reçu
+        get_pending_inputs(ports);
+        if (ports[0] != sent[0] || ports[1] != sent[1])
+        {
+            stream_send_inputs(ports[0], ports[1]);
+            sent[0] = ports[0];
+            sent[1] = ports[1];
+        }
+        if (max_frames && frames >= max_frames)
+            play = false;
+    }
+    if (got < 0)
+        printf("Stream view: the emulator closed the stream\n");
+    get_stream_stats(NULL, &vstats);
+    printf("Stream view: %u frames (%u keyframes), %u lost, %u hash mismatches, %llu bytes read\n",
+        vstats.frames, vstats.keyframes, vstats.lost, vstats.bad_hash, (unsigned long long)vstats.bytes);
+    if (frames)
+        printf("Stream view: frame %u at cycle %llu, VRAM hash %016llx\n", info.number,
+            (unsigned long long)info.cyc, (unsigned long long)info.hash);
+    stream_detach();
+    quit_video();
+    return 0;
+}
+
+// Banc d'essai de l'environnement vectorisé : politique aléatoire, sans fenêtre ni son
+static int run_vec_env(const char *rom, int nb_envs, int frame_skip, Vec_Obs obs_mode, uint32_t steps, int nb_threads)
+{
+    Vec_Env *env = create_vec_env(rom, nb_envs, frame_skip, obs_mode, nb_threads);
+    uint8_t *actions = malloc(nb_envs);
+    uint32_t seed = 0x2545F491;
+    uint64_t score_total = 0;
+    uint32_t best = 0;
+
+    if (!env || !actions)
+    {
+        printf("ERR: could not create %d environments (1 to %d, frame skip 1 to %d)\n", nb_envs, VECENV_MAX, VECENV_MAX_SKIP);
+        free(actions);
+        destroy_vec_env(env);
+        return 1;
+    }
+    uint64_t t0 = SDL_GetPerformanceCounter();
+    for (uint32_t step = 0; step < steps; step++)
+    {
+        for (int i = 0; i < nb_envs; i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            actions[i] = (seed >> 16) % NB_ACTIONS;
+        }
+        vec_env_step(env, actions);
+        for (int i = 0; i < nb_envs; i++)
+        {
+            if (!env->dones[i])
+                continue;
+            score_total += env->scores[i];
+            if (env->scores[i] > best)
+                best = env->scores[i];
+        }
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter() - t0) / SDL_GetPerformanceFrequency();
+    double frames = (double)steps * nb_envs * frame_skip;
+    printf("VecEnv: %d envs x %u steps (frame skip %d) on %d threads, %.0f steps/s, %.0f frames/s (%.0fx real time)\n",
+        nb_envs, steps, frame_skip, get_pool_size(), steps * nb_envs / seconds, frames / seconds, frames / seconds / 60);
+    printf("VecEnv: %u games over, mean score %.1f, best %u, %zu bytes of observation per env\n", env->episodes,
+        env->episodes ? (double)score_total / env->episodes : 0, best, env->obs_size);
+    free(actions);
+    destroy_vec_env(env);
+    quit_pool();
+    return 0;
+}
+
 void print_opcode(CPU *cpu, int cyc)
 {
     // uint8_t opcode = cpu->memory[cpu->pc];
@@ -93,19 +348,204 @@ void print_opcode(CPU *cpu, int cyc)
 
 int main(int ac, char **av)
 {
-    if (ac != 2)
+    const char *rom = NULL;
+    const char *overlay = "mono";
+    Filter_Kind filter = FILTER_NONE;
+    int scale = 1;
+    int nb_threads = 0;
+    const char *video = "sdl";
+    uint32_t max_frames = 0;
+    const char *record = NULL;
+    Rec_Format rec_format = REC_Y4M;
+    Rec_Policy rec_policy = REC_DROP;
+    int rec_queue = 64;
+    bool rec_dedup = false;
+    const char *pacing = NULL;
+    double hz = PACER_DEFAULT_HZ;
+    const char *sound = NULL;
+    Sound_Engine sound_engine = SOUND_SYNTH;
+    const char *samples = "rom/sounds";
+    int audio_latency = SOUND_DEFAULT_LATENCY;
+    const char *record_audio = NULL;
+    bool poll_per_interrupt = false;
+    const char *movie_record = NULL;
+    const char *movie_play = NULL;
+    int runahead = 0;
+    const char *state_file = "invaders.state";
+    const char *load_state_path = NULL;
+    int rewind_seconds = 0;
+    bool turbo = false;
+    int net_host = 0;
+    const char *net_join = NULL;
+    int net_delay = NET_DEFAULT_DELAY;
+    int net_latency = 0;
+    int net_loss = 0;
+    const char *input_bot = NULL;
+    const char *session_record = NULL;
+    int session_interval = SESSION_DEFAULT_INTERVAL;
+    const char *stream_path = NULL;
+    Stream_Format stream_format = STREAM_DELTA;
+    const char *stream_view = NULL;
+    int vec_envs = 0;
+    int vec_skip = 4;
+    Vec_Obs vec_obs = VEC_OBS_RAW;
+    bool obs_check = false;
+
+    for (int i = 1; i < ac; i++)
     {
-        printf("ERR: You need to specify the rom ex: ./bin/emu rom/invaders.rom\n");
+        if (strcmp(av[i], "--overlay") == 0 && i + 1 < ac)
+            overlay = av[++i];
+        else if (strcmp(av[i], "--filter") == 0 && i + 1 < ac)
+        {
+            if (parse_filter(av[++i], &filter) != 0)
+            {
+                printf("ERR: unknown filter %s (none, nearest, scale2x, scale3x, scanlines, crt)\n", av[i]);
+                return 0;
+            }
+        }
+        else if (strcmp(av[i], "--scale") == 0 && i + 1 < ac)
+            scale = atoi(av[++i]);
+        else if (strcmp(av[i], "--threads") == 0 && i + 1 < ac)
+            nb_threads = atoi(av[++i]);
+        else if (strcmp(av[i], "--video") == 0 && i + 1 < ac)
+            video = av[++i];
+        else if (strcmp(av[i], "--frames") == 0 && i + 1 < ac)
+            max_frames = (uint32_t)strtoul(av[++i], NULL, 10);
+        else if (strcmp(av[i], "--record") == 0 && i + 1 < ac)
+            record = av[++i];
+        else if (strcmp(av[i], "--record-format") == 0 && i + 1 < ac)
+        {
+            if (parse_rec_format(av[++i], &rec_format) != 0)
+            {
+                printf("ERR: unknown record format %s (y4m, raw, png)\n", av[i]);
+                return 0;
+            }
+        }
+        else if (strcmp(av[i], "--record-policy") == 0 && i + 1 < ac)
+            rec_policy = strcmp(av[++i], "block") == 0 ? REC_BLOCK : REC_DROP;
+        else if (strcmp(av[i], "--record-queue") == 0 && i + 1 < ac)
+            rec_queue = atoi(av[++i]);
+        else if (strcmp(av[i], "--record-dedup") == 0)
+            rec_dedup = true;
+        else if (strcmp(av[i], "--pacing") == 0 && i + 1 < ac)
+            pacing = av[++i];
+        else if (strcmp(av[i], "--hz") == 0 && i + 1 < ac)
+            hz = atof(av[++i]);
+        else if (strcmp(av[i], "--sound") == 0 && i + 1 < ac)
+            sound = av[++i];
+        else if (strcmp(av[i], "--sound-engine") == 0 && i + 1 < ac)
+        {
+            if (parse_sound_engine(av[++i], &sound_engine) != 0)
+            {
+                printf("ERR: unknown sound engine %s (synth, samples)\n", av[i]);
+                return 0;
+            }
+        }
+        else if (strcmp(av[i], "--samples") == 0 && i + 1 < ac)
+            samples = av[++i];
+        else if (strcmp(av[i], "--record-audio") == 0 && i + 1 < ac)
+            record_audio = av[++i];
+        else if (strcmp(av[i], "--input-poll") == 0 && i + 1 < ac)
+            poll_per_interrupt = strcmp(av[++i], "interrupt") == 0;
+        else if (strcmp(av[i], "--movie-record") == 0 && i + 1 < ac)
+            movie_record = av[++i];
+        else if (strcmp(av[i], "--movie-play") == 0 && i + 1 < ac)
+            movie_play = av[++i];
+        else if (strcmp(av[i], "--runahead") == 0 && i + 1 < ac)
+            runahead = atoi(av[++i]);
+        else if (strcmp(av[i], "--state") == 0 && i + 1 < ac)
+            state_file = av[++i];
+        else if (strcmp(av[i], "--load-state") == 0 && i + 1 < ac)
+            load_state_path = av[++i];
+        else if (strcmp(av[i], "--rewind") == 0 && i + 1 < ac)
+            rewind_seconds = atoi(av[++i]);
+        else if (strcmp(av[i], "--turbo") == 0)
+            turbo = true;
+        else if (strcmp(av[i], "--turbo-every") == 0 && i + 1 < ac)
+        {
+            if (set_turbo_every(atoi(av[++i])) != 0)
+            {
+                printf("ERR: invalid turbo frame skip %s (1 to %d)\n", av[i], PACER_TURBO_MAX);
+                return 0;
+            }
+        }
+        else if (strcmp(av[i], "--net-host") == 0 && i + 1 < ac)
+            net_host = atoi(av[++i]);
+        else if (strcmp(av[i], "--net-join") == 0 && i + 1 < ac)
+            net_join = av[++i];
+        else if (strcmp(av[i], "--net-delay") == 0 && i + 1 < ac)
+            net_delay = atoi(av[++i]);
+        else if (strcmp(av[i], "--net-latency") == 0 && i + 1 < ac)
+            net_latency = atoi(av[++i]);
+        else if (strcmp(av[i], "--net-loss") == 0 && i + 1 < ac)
+            net_loss = atoi(av[++i]);
+        else if (strcmp(av[i], "--input-bot") == 0 && i + 1 < ac)
+            input_bot = av[++i];
+        else if (strcmp(av[i], "--session-record") == 0 && i + 1 < ac)
+            session_record = av[++i];
+        else if (strcmp(av[i], "--session-interval") == 0 && i + 1 < ac)
+            session_interval = atoi(av[++i]);
+        else if (strcmp(av[i], "--stream") == 0 && i + 1 < ac)
+            stream_path = av[++i];
+        else if (strcmp(av[i], "--stream-format") == 0 && i + 1 < ac)
+        {
+            if (parse_stream_format(av[++i], &stream_format) != 0)
+            {
+                printf("ERR: unknown stream format %s (raw, delta)\n", av[i]);
+                return 0;
+            }
+        }
+        else if (strcmp(av[i], "--stream-view") == 0 && i + 1 < ac)
+            stream_view = av[++i];
+        else if (strcmp(av[i], "--vecenv") == 0 && i + 1 < ac)
+            vec_envs = atoi(av[++i]);
+        else if (strcmp(av[i], "--vecenv-skip") == 0 && i + 1 < ac)
+            vec_skip = atoi(av[++i]);
+        else if (strcmp(av[i], "--vecenv-obs") == 0 && i + 1 < ac)
+        {
+            if (parse_vec_obs(av[++i], &vec_obs) != 0)
+            {
+                printf("ERR: unknown observation %s (raw, packed, gray, pooled)\n", av[i]);
+                return 0;
+            }
+        }
+        else if (strcmp(av[i], "--obs-check") == 0)
+            obs_check = true;
+        else if (strcmp(av[i], "--audio-latency") == 0 && i + 1 < ac)
+            audio_latency = atoi(av[++i]);
+        else
+            rom = av[i];
+    }
+    if (!rom && !stream_view)
+    {
+        printf("ERR: You need to specify the rom ex: ./bin/emu [--overlay mono|cabinet|file] [--filter name] [--scale n] [--threads n] [--video sdl|null|offscreen] [--frames n] [--record file] [--record-format y4m|raw|png] [--record-policy drop|block] [--record-queue n] [--record-dedup] [--pacing off|vsync|timer|audio] [--hz f] [--sound on|off] [--sound-engine synth|samples] [--samples dir] [--audio-latency ms] [--record-audio file.wav] [--input-poll frame|interrupt] [--movie-record file] [--movie-play file] [--runahead n] [--state file] [--load-state file] [--rewind seconds] [--turbo] [--turbo-every n] [--net-host port | --net-join addr:port] [--net-delay n] [--net-latency ms] [--net-loss pct] [--input-bot seed] [--session-record file] [--session-interval n] [--stream socket] [--stream-format raw|delta] [--stream-view socket] [--vecenv n] [--vecenv-skip k] [--vecenv-obs raw|packed|gray|pooled] [--obs-check] rom/invaders.rom\n");
+        return 0;
+    }
+    // --frames compte alors les pas de chaque env
+    if (vec_envs)
+        return run_vec_env(rom, vec_envs, vec_skip, vec_obs, max_frames ? max_frames : 10000, nb_threads);
+    if (filter == FILTER_NEAREST && scale == 1)
+        scale = 2;
+    if (init_filter(filter, scale, nb_threads) != 0)
+    {
+        printf("ERR: invalid scale %d (1 to 8)\n", scale);
         return 0;
     }
+    // Pas de machine de ce côté : les frames viennent d'un autre emu
+    if (stream_view)
+        return run_stream_view(stream_view, video, overlay, max_frames);
 
     CPU cpu;
     bool play_emu = true;
 
     init_cpu(&cpu);
+    cpu.hooks.frame = on_frame;
+    cpu.hooks.sound = on_sound;
     printf("Le CPU a bien été initialisé\n");
-    load_rom(&cpu, av[1]);
+    load_rom(&cpu, rom);
     printf("La ROM a bien été chargé\n");
+    if (load_overlay(overlay) != 0)
+        printf("ERR: overlay %s could not be loaded, using mono\n", overlay);
 
     /*int i = 0;
     while (i < MEMORY_SIZE)
@@ -114,18 +554,260 @@ int main(int ac, char **av)
         if (i % 16 == 0) printf("\n");
     }*/
 
-    init_sdl();
+    // Par défaut : horloge pour la fenêtre SDL, aussi vite que possible sans affichage
+    Pacing_Mode pacing_mode = strcmp(video, "sdl") == 0 ? PACING_TIMER : PACING_OFF;
+    if (pacing && parse_pacing(pacing, &pacing_mode) != 0)
+    {
+        printf("ERR: unknown pacing %s (off, vsync, timer, audio)\n", pacing);
+        return 0;
+    }
+    set_vsync(pacing_mode == PACING_VSYNC);
+    if (init_video(video) != 0)
+        return 1;
+    if (record && start_recorder(record, rec_format, rec_policy, rec_queue, rec_dedup) != 0)
+        printf("ERR: could not start recording to %s\n", record);
+    if (stream_path && start_stream_server(stream_path, stream_format) != 0)
+    {
+        printf("ERR: could not stream to %s\n", stream_path);
+        stream_path = NULL;
+    }
+    else if (stream_path)
+        add_frame_consumer(stream_consumer, NULL);
+    if (obs_check)
+        add_frame_consumer(obs_check_consumer, NULL);
+    // Le son suit la fenêtre par défaut : pas de périphérique audio en headless
+    bool sound_on = sound ? strcmp(sound, "on") == 0 : get_video_backend()->has_window;
+    if (pacing_mode == PACING_AUDIO)
+        sound_on = true;
+    if (init_sound(sound_engine, samples, sound_on, audio_latency) != 0)
+        printf("ERR: audio output could not be opened, running without sound\n");
+    if (record_audio && start_sound_capture(record_audio, get_cyc(&cpu)) != 0)
+        printf("ERR: could not start audio capture to %s\n", record_audio);
+    if (pacing_mode == PACING_AUDIO && !sound_is_output())
+    {
+        printf("ERR: audio pacing needs an audio output, using timer\n");
+        pacing_mode = PACING_TIMER;
+    }
+    bool netplay = net_host || net_join;
+    // Un film rejoué peut servir d'entrée locale, mais rien ne peut revenir en arrière
+    if (netplay && (movie_record || rewind_seconds))
+    {
+        printf("ERR: netplay cannot be combined with movie recording or rewind\n");
+        return 0;
+    }
+    // Les deux machines doivent lire les entrées aux mêmes points, une fois par frame
+    poll_per_interrupt = poll_per_interrupt && !netplay;
+    if (netplay && init_netplay(net_join, net_host ? net_host : NET_DEFAULT_PORT, net_delay) != 0)
+    {
+        printf("ERR: could not start netplay (input delay 0 to %d)\n", NET_MAX_DELAY);
+        return 1;
+    }
+    set_net_shim(net_latency, net_loss);
+    if (input_bot)
+        set_input_bot((uint32_t)strtoul(input_bot, NULL, 10));
+    // Le rejeu impose le mode de lecture des entrées de l'enregistrement
+    if (movie_play && start_movie_play(movie_play, &poll_per_interrupt) != 0)
+    {
+        printf("ERR: could not play movie %s\n", movie_play);
+        return 1;
+    }
+    if (movie_record && start_movie_record(movie_record, poll_per_interrupt) != 0)
+        printf("ERR: could not record movie to %s\n", movie_record);
+    if (load_state_path && load_state_file(&cpu, load_state_path) != 0)
+        printf("ERR: %s is not a save state for this ROM and version\n", load_state_path);
+    else if (load_state_path)
+        sound_seek(get_cyc(&cpu), cpu.io.sound);
+    // Une session rejoue les entrées frame par frame depuis ses checkpoints
+    if (session_record && poll_per_interrupt)
+    {
+        printf("ERR: sessions need --input-poll frame, not recording %s\n", session_record);
+        session_record = NULL;
+    }
+    else if (session_record && start_session_record(session_record, session_interval) != 0)
+    {
+        printf("ERR: could not record session to %s\n", session_record);
+        session_record = NULL;
+    }
+    // Un film suppose une partie qui ne revient jamais en arrière
+    if (rewind_seconds && (movie_play || movie_record || session_record))
+        printf("ERR: rewind is disabled while a movie or session is recorded or played\n");
+    else if (init_rewind(rewind_seconds) != 0)
+        printf("ERR: not enough memory for %d seconds of rewind\n", rewind_seconds);
+    if (init_runahead(runahead) != 0)
+    {
+        printf("ERR: invalid run-ahead %d (0 to %d)\n", runahead, RUNAHEAD_MAX);
+        return 0;
+    }
+    init_pacer(pacing_mode, hz, get_cyc(&cpu));
+    if (turbo)
+        apply_turbo(true, pacing_mode);
+    // Sans fenêtre (null, offscreen) il n'y a pas d'événements SDL à lire
+    bool has_window = get_video_backend()->has_window;
     while (play_emu)
     {
-        SDL_Event e;    
-        while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_EVENT_QUIT) {SDL_exit(); exit(0);}
-            else if (e.type == SDL_EVENT_KEY_DOWN && e.key.key == SDLK_ESCAPE) {SDL_exit(); exit(0);}
-            else update_input_keyboard(&e);
+        Emu_Event ev;
+        // Une frame en arrière par frame affichée, sans émuler
+        if (rewinding && rewind_enabled())
+        {
+            if (rewind_step(&cpu))
+            {
+                sound_seek(get_cyc(&cpu), cpu.io.sound);
+                present_frame(get_vram(&cpu), get_cyc(&cpu));
+            }
+            pacer_end_frame(get_cyc(&cpu));
+            show_speed(has_window);
+            play_emu = poll_input(&cpu, has_window);
+            continue;
         }
-        // print_opcode(&cpu, get_cyc());
-        step_emu(&cpu);
+        // print_opcode(&cpu, get_cyc(&cpu));
+        ev = run_emu(&cpu);
+        if (ev == EMU_END_FRAME)
+        {
+            sound_end_frame(get_cyc(&cpu));
+            pacer_end_frame(get_cyc(&cpu));
+            show_speed(has_window);
+        }
+        if (ev == EMU_END_FRAME && stream_path)
+        {
+            uint8_t remote[2];
+            stream_poll(remote);
+            set_remote_inputs(remote);
+        }
+        // Entrées lues au VBlank, après l'attente du pacer, juste avant que
+        // l'interrupt du jeu ne les consulte
+        if (ev == EMU_END_FRAME || poll_per_interrupt)
+            play_emu = poll_input(&cpu, has_window);
+        // F5 / F9, entre deux frames pour que l'état soit à un point stable
+        if (ev == EMU_END_FRAME && state_request != STATE_NONE)
+        {
+            if (state_request == STATE_SAVE && save_state_file(&cpu, state_file) == 0)
+                printf("State saved to %s\n", state_file);
+            else if (state_request == STATE_LOAD && netplay_active())
+                printf("ERR: states cannot be loaded during netplay\n");
+            else if (state_request == STATE_LOAD && session_record)
+                printf("ERR: states cannot be loaded while a session is recorded\n");
+            else if (state_request == STATE_LOAD && load_state_file(&cpu, state_file) != 0)
+                printf("ERR: could not load state %s\n", state_file);
+            else if (state_request == STATE_LOAD)
+                sound_seek(get_cyc(&cpu), cpu.io.sound);
+            state_request = STATE_NONE;
+        }
+        if (turbo_toggle)
+        {
+            apply_turbo(!get_turbo(), pacing_mode);
+            turbo_toggle = false;
+        }
+        if (ev == EMU_END_FRAME && !netplay_frame(&cpu))
+        {
+            printf("ERR: netplay peer lost\n");
+            play_emu = false;
+        }
+        // État réel de la frame, avant les frames jouées en avance
+        if (ev == EMU_END_FRAME)
+        {
+            session_latch(&cpu, cpu.io.latched[0], cpu.io.latched[1]);
+            rewind_capture(&cpu);
+            run_ahead(&cpu);
+        }
+        if (max_frames && get_frame_number() >= max_frames)
+            play_emu = false;
+        if (movie_finished())
+            play_emu = false;
+    }
+    if (netplay_active())
+    {
+        Net_Stats nstats;
+        netplay_finish(&cpu);
+        get_net_stats(&nstats);
+        printf("Netplay: %u frames, %u rollbacks (depth avg %.2f / max %u), %u frames resimulated at %.1f us each (max rollback %.0f us), %u stalls, %u waits\n",
+            nstats.frames, nstats.rollbacks, nstats.depth_avg, nstats.depth_max, nstats.resimulated,
+            nstats.resim_avg_us, nstats.resim_max_us, nstats.stalls, nstats.waits);
+        if (nstats.resimulated)
+            printf("Netplay headroom: %.0f resimulated frames fit in one %.2f Hz frame\n",
+                1000000.0 / hz / nstats.resim_avg_us, hz);
+        printf("Netplay network: %u packets sent (%u dropped by the shim), %u received, %u sync checks, %u desyncs\n",
+            nstats.sent, nstats.dropped, nstats.received, nstats.checks, nstats.desyncs);
+        printf("Netplay: frame %u at cycle %llu, VRAM hash %016llx\n", get_net_frame(),
+            (unsigned long long)get_cyc(&cpu), (unsigned long long)hash_vram(get_vram(&cpu)));
+        quit_netplay();
+    }
+    Pacer_Stats pstats;
+    get_pacer_stats(&pstats);
+    printf("Frames: %u (%u presented, %u skipped, %u late), %.2f fps, host cost min %.0f / avg %.0f / max %.0f us\n",
+        pstats.frames, pstats.presented, pstats.skipped, pstats.late, pstats.fps,
+        pstats.cost_min_us, pstats.cost_avg_us, pstats.cost_max_us);
+    if (record)
+    {
+        Recorder_Stats stats;
+        stop_recorder();
+        get_recorder_stats(&stats);
+        printf("Record: %u frames written, %u dropped, %u duplicates skipped, max queue depth %u\n",
+            stats.written, stats.dropped, stats.skipped, stats.max_depth);
+    }
+    if (stream_path)
+    {
+        Stream_Stats ststats;
+        remove_frame_consumer(stream_consumer, NULL);
+        get_stream_stats(&ststats, NULL);
+        stop_stream_server();
+        printf("Stream: %u frames published (%u keyframes, %u unchanged skipped), %llu bytes, %u viewers, %u input updates\n",
+            ststats.frames, ststats.keyframes, ststats.unchanged, (unsigned long long)ststats.bytes, ststats.viewers,
+            ststats.inputs);
+    }
+    if (obs_check)
+    {
+        remove_frame_consumer(obs_check_consumer, NULL);
+        printf("Obs check: %u frames, %u mismatches\n", obs_checked, obs_mismatches);
+    }
+    if (record_audio)
+    {
+        Wav_Stats wstats;
+        stop_sound_capture();
+        get_wav_stats(&wstats);
+        printf("Audio record: %llu samples from cycle %llu, max queue depth %u, %u stalls\n",
+            (unsigned long long)wstats.samples, (unsigned long long)(wstats.start_sample * CPU_CLOCK / SOUND_RATE),
+            wstats.max_depth, wstats.stalls);
+    }
+    if (session_record)
+    {
+        Session_Stats sestats;
+        stop_session_record();
+        get_session_stats(&sestats, NULL);
+        printf("Session record: %u frames, %u checkpoints, %llu bytes\n", sestats.frames, sestats.checkpoints,
+            (unsigned long long)sestats.bytes);
+    }
+    if (movie_play || movie_record)
+    {
+        Movie_Stats played, recorded;
+        stop_movie();
+        get_movie_stats(&played, &recorded);
+        if (movie_play)
+            printf("Movie play: %u latches, %u runs%s\n", played.latches, played.runs, played.finished ? ", finished" : "");
+        if (movie_record)
+            printf("Movie record: %u latches, %u runs, %u bytes\n", recorded.latches, recorded.runs, recorded.bytes);
+        // Même film, même hash : de quoi vérifier un rejeu bit à bit
+        printf("Movie: frame %u at cycle %llu, VRAM hash %016llx\n", get_frame_number(),
+            (unsigned long long)get_cyc(&cpu), (unsigned long long)hash_vram(get_vram(&cpu)));
+    }
+    if (rewind_enabled())
+    {
+        Rewind_Stats rstats;
+        get_rewind_stats(&rstats);
+        printf("Rewind: %u frames kept, %u / %u bytes, delta avg %.0f bytes, capture avg %.2f us\n",
+            rstats.frames, rstats.bytes, rstats.capacity, rstats.delta_avg, rstats.capture_avg_us);
+        quit_rewind();
+    }
+    Sound_Stats sstats;
+    get_sound_stats(&sstats);
+    if (sound_on)
+    {
+        printf("Sound: %u events, %u underruns, %u samples lost\n", sstats.events, sstats.underruns, sstats.overruns);
+        printf("Audio: fill min %u / avg %.0f / max %u (target %u samples), latency %.1f ms, ratio %.4f (%.4f to %.4f)\n",
+            sstats.fill_min, sstats.fill_avg, sstats.fill_max, sstats.target, sstats.latency_ms,
+            sstats.ratio, sstats.ratio_min, sstats.ratio_max);
     }
+    quit_sound();
+    quit_video();
 
     return 0;
 }
\ No newline at end of file
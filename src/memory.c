@@ -1,12 +1,23 @@
 #include "../includes/memory.h"
 #include "../includes/cpu8080.h"
-#include "../includes/i8080_test.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-static uint8_t ram[0x400] = {0};
-static uint8_t vram[0x1C00] = {0};
+/*
+Carte mémoire de la borne, dans cpu->memory : ROM de 0x0000 à 0x1FFF (jamais
+écrite), RAM de 0x2000 à 0x23FF, VRAM de 0x2400 à 0x3FFF, le tout répété
+au-delà de 0x4000. Avec flat_memory (ROM de test), les 64 Ko sont de la RAM.
+*/
+
+// FNV-1a de la ROM, gardé avec la machine : les sauvegardes d'une autre ROM sont refusées
+static void hash_rom(CPU *cpu)
+{
+    cpu->rom_hash = 0xCBF29CE484222325ull;
+    for (int i = 0; i < MEMORY_SIZE; i++)
+        cpu->rom_hash = (cpu->rom_hash ^ cpu->memory[i]) * 0x100000001B3ull;
+}
 
 int load_rom(CPU *cpu, const char path[])
 {
@@ -18,40 +29,103 @@ int load_rom(CPU *cpu, const char path[])
     }
     fread(cpu->memory, sizeof(uint8_t) * (MEMORY_SIZE), 1, rom);
     fclose(rom);
+    hash_rom(cpu);
+    return 0;
+}
+
+int load_rom_data(CPU *cpu, const uint8_t *data, size_t size)
+{
+    if (size > MEMORY_SIZE)
+        return -1;
+    memset(cpu->memory, 0, MEMORY_SIZE);
+    memcpy(cpu->memory, data, size);
+    hash_rom(cpu);
     return 0;
 }
 
-uint8_t read_memory(CPU *cpu, uint16_t addr)
+uint8_t read_memory(const CPU *cpu, uint16_t addr)
 {
-    if (addr >= 0x4000)
+    if (addr >= 0x4000 && !cpu->flat_memory)
         addr = 0x2000 + ((addr - 0x2000) & 0x1FFF);
+    return cpu->memory[addr];
+}
 
-    if (addr < 0x2000)
-        return cpu->memory[addr];
-    else if (addr < 0x2400)
-        return ram[addr - 0x2000];
-    else if (addr < 0x4000)
-        return vram[addr - 0x2400];
-    else
+void write_memory(CPU *cpu, uint16_t addr, uint8_t value)
+{
+    if (!cpu->flat_memory)
     {
-        printf("Out of range read (addr: %04X)", addr);
-        exit(0);
+        if (addr >= 0x4000)
+            addr = 0x2000 + ((addr - 0x2000) & 0x1FFF);
+        if (addr < RAM_START)
+            return;
     }
-    return 0;
+    cpu->memory[addr] = value;
 }
 
-void write_memory(uint16_t addr, uint8_t value)
+// Accès direct à la VRAM (1bpp, 32 octets par ligne native) pour la vidéo
+const uint8_t *get_vram(const CPU *cpu)
 {
-    if (addr >= 0x4000)
-        addr = 0x2000 + ((addr - 0x2000) & 0x1FFF);
-    
-    if (addr < 0x2400)
-        ram[addr - 0x2000] = value;
-    else if (addr < 0x4000)
-        vram[addr - 0x2400] = value;
-    else
+    return cpu->memory + VRAM_START;
+}
+
+#define PRIME64_1 0x9E3779B185EBCA87ull
+#define PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define PRIME64_3 0x165667B19E3779F9ull
+#define PRIME64_4 0x85EBCA77C2B2AE63ull
+#define PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t xxh_merge(uint64_t h, uint64_t acc)
+{
+    h ^= xxh_round(0, acc);
+    return h * PRIME64_1 + PRIME64_4;
+}
+
+// XXH64 (graine 0) sur les 7 Ko de VRAM : 4 accumulateurs indépendants, environ 1 µs.
+// VRAM_SIZE est un multiple de 32, il n'y a pas de reste à traiter.
+uint64_t hash_vram(const uint8_t *vram)
+{
+    uint64_t v1 = PRIME64_1 + PRIME64_2;
+    uint64_t v2 = PRIME64_2;
+    uint64_t v3 = 0;
+    uint64_t v4 = 0 - PRIME64_1;
+
+    for (int i = 0; i < VRAM_SIZE; i += 32)
     {
-        printf("Out of range write (addr: %04X)", addr);
-        exit(0);
+        v1 = xxh_round(v1, read64(vram + i));
+        v2 = xxh_round(v2, read64(vram + i + 8));
+        v3 = xxh_round(v3, read64(vram + i + 16));
+        v4 = xxh_round(v4, read64(vram + i + 24));
     }
-}
\ No newline at end of file
+    uint64_t h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    h = xxh_merge(h, v1);
+    h = xxh_merge(h, v2);
+    h = xxh_merge(h, v3);
+    h = xxh_merge(h, v4);
+    h += VRAM_SIZE;
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
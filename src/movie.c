@@ -0,0 +1,202 @@
+#include "../includes/movie.h"
+#include "../includes/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Film d'entrées : l'état des ports 1 et 2 à chaque latch_inputs(), c'est-à-dire
+aux mêmes cycles émulés d'une exécution à l'autre. L'émulation étant
+déterministe depuis la mise sous tension, rejouer le film redonne exactement
+la même partie.
+
+Format (petit-boutiste) :
+ "SIMV", version (1 octet), flags (1 octet, bit 0 = lecture aussi au milieu de
+ l'écran), 2 octets réservés, nombre total de latches (4 octets)
+ puis des suites : port 1, port 2, longueur (entier variable, 7 bits par octet)
+Une suite n'est écrite que quand l'état change.
+*/
+
+#define HEADER_SIZE 12
+#define FLAG_PER_INTERRUPT 1
+
+static struct
+{
+    FILE *out;
+    uint8_t cur[2];
+    uint32_t run;
+    Movie_Stats stats;
+} rec;
+
+static struct
+{
+    uint8_t *data;
+    uint32_t len;
+    uint32_t pos;
+    uint8_t cur[2];
+    uint32_t left; // Latches restants dans la suite courante
+    Movie_Stats stats;
+} play;
+
+static void write_run()
+{
+    uint8_t buf[2 + 5];
+    int n = 2;
+    uint32_t run = rec.run;
+
+    buf[0] = rec.cur[0];
+    buf[1] = rec.cur[1];
+    do
+    {
+        buf[n++] = (run & 0x7F) | (run > 0x7F ? 0x80 : 0);
+        run >>= 7;
+    } while (run);
+    fwrite(buf, 1, n, rec.out);
+    rec.stats.runs++;
+    rec.stats.bytes += n;
+}
+
+int start_movie_record(const char *path, bool per_interrupt)
+{
+    uint8_t header[HEADER_SIZE] = { 'S', 'I', 'M', 'V', MOVIE_VERSION, per_interrupt ? FLAG_PER_INTERRUPT : 0 };
+
+    if (rec.out)
+        return -1;
+    rec.out = fopen(path, "wb");
+    if (!rec.out)
+    {
+        perror("Error fopen movie:");
+        return -1;
+    }
+    fwrite(header, 1, sizeof(header), rec.out);
+    rec.run = 0;
+    memset(&rec.stats, 0, sizeof(rec.stats));
+    rec.stats.bytes = HEADER_SIZE;
+    return 0;
+}
+
+// per_interrupt: reçoit le mode de lecture des entrées de l'enregistrement,
+// à réutiliser tel quel pour retomber sur les mêmes cycles
+int start_movie_play(const char *path, bool *per_interrupt)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        perror("Error fopen movie:");
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < HEADER_SIZE)
+    {
+        fclose(f);
+        return -1;
+    }
+    free(play.data);
+    play.data = malloc(size);
+    if (!play.data || fread(play.data, 1, size, f) != (size_t)size)
+    {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    if (memcmp(play.data, "SIMV", 4) != 0 || play.data[4] != MOVIE_VERSION)
+    {
+        printf("ERR: %s is not a version %d movie\n", path, MOVIE_VERSION);
+        return -1;
+    }
+    *per_interrupt = play.data[5] & FLAG_PER_INTERRUPT;
+    play.len = size;
+    play.pos = HEADER_SIZE;
+    play.left = 0;
+    memset(&play.stats, 0, sizeof(play.stats));
+    play.stats.bytes = size;
+    return 0;
+}
+
+static bool read_run()
+{
+    uint32_t run = 0;
+
+    if (play.pos + 3 > play.len)
+        return false;
+    play.cur[0] = play.data[play.pos++];
+    play.cur[1] = play.data[play.pos++];
+    for (int shift = 0; play.pos < play.len && shift < 35; shift += 7)
+    {
+        uint8_t b = play.data[play.pos++];
+        run |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            break;
+    }
+    play.left = run;
+    play.stats.runs++;
+    return run > 0;
+}
+
+// Appelé par latch_inputs() : remplace les entrées de l'hôte en rejeu,
+// puis enregistre ce que le jeu va réellement lire
+void movie_latch(uint8_t ports[2])
+{
+    if (play.data && !play.stats.finished)
+    {
+        if (!play.left && !read_run())
+            play.stats.finished = true;
+        else
+        {
+            ports[0] = play.cur[0];
+            ports[1] = play.cur[1];
+            play.left--;
+            play.stats.latches++;
+            // Dernier latch du film : fini tout de suite, pas au suivant
+            if (!play.left && play.pos + 3 > play.len)
+                play.stats.finished = true;
+        }
+    }
+    if (rec.out)
+    {
+        if (rec.run && ports[0] == rec.cur[0] && ports[1] == rec.cur[1])
+            rec.run++;
+        else
+        {
+            if (rec.run)
+                write_run();
+            rec.cur[0] = ports[0];
+            rec.cur[1] = ports[1];
+            rec.run = 1;
+        }
+        rec.stats.latches++;
+    }
+}
+
+bool movie_finished()
+{
+    return play.data && play.stats.finished;
+}
+
+void stop_movie()
+{
+    if (rec.out)
+    {
+        uint8_t count[4];
+        if (rec.run)
+            write_run();
+        put_le32(count, rec.stats.latches);
+        fseek(rec.out, 8, SEEK_SET);
+        fwrite(count, 1, 4, rec.out);
+        fclose(rec.out);
+        rec.out = NULL;
+    }
+    free(play.data);
+    play.data = NULL;
+}
+
+void get_movie_stats(Movie_Stats *p, Movie_Stats *r)
+{
+    if (p)
+        *p = play.stats;
+    if (r)
+        *r = rec.stats;
+}
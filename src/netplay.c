@@ -0,0 +1,542 @@
+#ifdef _WIN32
+# include <winsock2.h>
+# include <ws2tcpip.h>
+typedef SOCKET Net_Socket;
+typedef int socklen_t;
+#else
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <netdb.h>
+# include <fcntl.h>
+# include <unistd.h>
+typedef int Net_Socket;
+# define INVALID_SOCKET -1
+# define closesocket close
+#endif
+
+#include "../includes/netplay.h"
+#include "../includes/snapshot.h"
+#include "../includes/frame.h"
+#include "../includes/pacer.h"
+#include "../includes/sound.h"
+#include "../includes/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <../includes/SDL3/SDL.h>
+
+/*
+Netplay à deux joueurs, par rollback. L'hôte est le joueur 1 et a la main sur
+toutes les entrées sauf celles du joueur 2 (port 2 : tir, gauche, droite, et
+le bouton 2P start), qui appartiennent à l'invité.
+
+Chaque frame, la touche lue localement est affectée à la frame courante +
+delay, et envoyée à l'autre. L'entrée de l'autre pour la frame courante est
+prise si elle est arrivée, sinon prédite (la dernière reçue). Quand l'entrée
+réelle arrive et diffère de la prédiction, la machine recharge l'état du
+début de cette frame et rejoue jusqu'à la frame courante, sans affichage ni
+son. Il faut donc un snapshot par frame non confirmée : au-delà de
+NET_MAX_ROLLBACK frames d'avance, on attend l'autre.
+
+UDP, sans connexion : chaque paquet répète toutes nos entrées que l'autre n'a
+pas encore acquittées, une perte est rattrapée par le paquet suivant. Les
+paquets portent aussi l'avance de chacun (pour ralentir celui qui court
+devant) et, toutes les NET_CHECK_EVERY frames confirmées, un hash de la
+mémoire pour détecter une désynchronisation.
+
+Paquet (petit-boutiste) :
+ "SINP", version, delay, nombre d'entrées, avance (signée),
+ identifiant de la ROM (4 octets), première frame attendue de l'autre,
+ première frame des entrées, frame et hash de la dernière vérification,
+ puis 2 octets (port 1, port 2) par frame
+
+Pour les tests, un simulateur de réseau retarde les paquets sortants
+(latency) et en jette une partie (loss).
+*/
+
+#define NET_VERSION 1
+#define NET_INPUTS 256 // Historique des entrées, en frames
+#define NET_SNAPS (NET_MAX_ROLLBACK + 2)
+#define NET_MAX_SEND 64
+#define NET_HEADER 28
+#define NET_PACKET (NET_HEADER + NET_MAX_SEND * 2)
+#define NET_CHECK_EVERY 60
+#define NET_RESEND_MS 5         // Renvoi des entrées pendant une attente
+#define NET_TIMEOUT 5000        // ms sans nouvelles de l'autre avant d'abandonner
+#define NET_CONNECT_TIMEOUT 30000
+#define NET_FINISH_TIMEOUT 2000
+#define NET_SHIM_QUEUE 512
+#define NET_NONE UINT32_MAX
+
+typedef struct Shim_Packet
+{
+    uint64_t due; // SDL_GetTicks() d'envoi
+    int len;
+    uint8_t data[NET_PACKET];
+} Shim_Packet;
+
+static Net_Socket sock = INVALID_SOCKET;
+static struct sockaddr_in peer;
+static bool has_peer = false;
+static bool is_host = false;
+static int delay = NET_DEFAULT_DELAY;
+static uint32_t rom_id;
+static uint8_t local_mask[2];
+static uint8_t remote_mask[2];
+
+static uint32_t frame = 0;       // Prochaine frame à émuler
+static uint32_t local_next = 0;  // Première frame sans entrée locale
+static uint32_t remote_next = 0; // Première frame sans entrée de l'autre
+static uint32_t remote_ack = 0;  // Première de nos frames que l'autre n'a pas
+static int remote_adv = 0;
+static uint32_t rollback_from = NET_NONE;
+static uint8_t local_in[NET_INPUTS][2];
+static uint8_t remote_in[NET_INPUTS][2];
+static uint8_t used_in[NET_INPUTS][2]; // Entrée de l'autre avec laquelle la frame a été jouée
+static uint8_t last_remote[2];
+static Snapshot snaps[NET_SNAPS];   // Début de chaque frame encore révisable
+
+static uint32_t next_check = NET_CHECK_EVERY;
+static uint32_t check_frame = NET_NONE;
+static uint32_t check_hash = 0;
+static uint32_t peer_check_frame = NET_NONE;
+static uint32_t peer_check_hash = 0;
+static uint32_t compared = NET_NONE;
+
+static uint64_t last_recv;
+static uint64_t last_send;
+static uint32_t last_stall = 0;
+static bool mismatch_reported = false;
+
+static int latency_ms = 0;
+static int loss_pct = 0;
+static uint32_t rng = 0x2545F491;
+static Shim_Packet shim[NET_SHIM_QUEUE];
+static int shim_first = 0;
+static int shim_count = 0;
+
+static Net_Stats stats;
+static uint64_t resim_ticks = 0;
+static uint64_t resim_max = 0;
+
+static int open_socket(int port)
+{
+    struct sockaddr_in addr;
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        return -1;
+#endif
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == INVALID_SOCKET)
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        perror("Error bind netplay:");
+        return -1;
+    }
+#ifdef _WIN32
+    u_long nonblock = 1;
+    ioctlsocket(sock, FIONBIO, &nonblock);
+#else
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    return 0;
+}
+
+// "adresse:port" de l'hôte
+static int resolve_peer(const char *join)
+{
+    char host[256], default_port[8];
+    const char *colon = strrchr(join, ':');
+    const char *port = colon ? colon + 1 : default_port;
+    size_t len = colon ? (size_t)(colon - join) : strlen(join);
+    struct addrinfo hints, *res;
+
+    if (len >= sizeof(host))
+        return -1;
+    snprintf(default_port, sizeof(default_port), "%d", NET_DEFAULT_PORT);
+    memcpy(host, join, len);
+    host[len] = '\0';
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+        return -1;
+    memcpy(&peer, res->ai_addr, sizeof(peer));
+    freeaddrinfo(res);
+    has_peer = true;
+    return 0;
+}
+
+// join: NULL pour être l'hôte sur port, sinon "adresse:port" de l'hôte à rejoindre
+int init_netplay(const char *join, int port, int d)
+{
+    uint8_t p2_mask[2] = { 0, 0 };
+
+    if (d < 0 || d > NET_MAX_DELAY)
+        return -1;
+    is_host = join == NULL;
+    delay = d;
+    if (open_socket(is_host ? port : 0) != 0 || (join && resolve_peer(join) != 0))
+    {
+        quit_netplay();
+        return -1;
+    }
+    get_io_mask(TWO_P_START, p2_mask);
+    get_io_mask(TWO_P_SHOOT, p2_mask);
+    get_io_mask(TWO_P_LEFT, p2_mask);
+    get_io_mask(TWO_P_RIGHT, p2_mask);
+    for (int i = 0; i < 2; i++)
+    {
+        local_mask[i] = is_host ? ~p2_mask[i] : p2_mask[i];
+        remote_mask[i] = ~local_mask[i];
+    }
+    // Les frames avant le premier délai n'ont d'entrée ni d'un côté ni de l'autre
+    frame = 0;
+    local_next = remote_next = delay;
+    last_recv = last_send = SDL_GetTicks();
+    rng ^= is_host ? 0 : 0x9E3779B9;
+    return 0;
+}
+
+void set_net_shim(int latency, int loss)
+{
+    latency_ms = latency > 0 ? latency : 0;
+    loss_pct = loss > 0 ? loss : 0;
+}
+
+bool netplay_active()
+{
+    return sock != INVALID_SOCKET;
+}
+
+uint32_t get_net_frame()
+{
+    return frame;
+}
+
+static uint32_t next_rand()
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void send_raw(const uint8_t *data, int len)
+{
+    sendto(sock, (const char *)data, len, 0, (struct sockaddr *)&peer, sizeof(peer));
+}
+
+static void flush_shim()
+{
+    uint64_t now = SDL_GetTicks();
+
+    while (shim_count && shim[shim_first].due <= now)
+    {
+        send_raw(shim[shim_first].data, shim[shim_first].len);
+        shim_first = (shim_first + 1) % NET_SHIM_QUEUE;
+        shim_count--;
+    }
+}
+
+static void send_packet(const uint8_t *data, int len)
+{
+    stats.sent++;
+    if (loss_pct && (int)(next_rand() % 100) < loss_pct)
+    {
+        stats.dropped++;
+        return;
+    }
+    if (!latency_ms)
+    {
+        send_raw(data, len);
+        return;
+    }
+    if (shim_count == NET_SHIM_QUEUE)
+    {
+        stats.dropped++;
+        return;
+    }
+    Shim_Packet *p = &shim[(shim_first + shim_count++) % NET_SHIM_QUEUE];
+    p->due = SDL_GetTicks() + latency_ms;
+    p->len = len;
+    memcpy(p->data, data, len);
+}
+
+static void send_inputs()
+{
+    uint8_t buf[NET_PACKET];
+    uint32_t count = local_next - remote_ack;
+    int adv = (int)(frame - remote_next);
+
+    // L'hôte ne connaît l'invité qu'à son premier paquet
+    if (!has_peer)
+        return;
+    if (count > NET_MAX_SEND)
+        count = NET_MAX_SEND;
+    memcpy(buf, "SINP", 4);
+    buf[4] = NET_VERSION;
+    buf[5] = delay;
+    buf[6] = count;
+    buf[7] = (int8_t)(adv < -128 ? -128 : adv > 127 ? 127 : adv);
+    put_le32(buf + 8, rom_id);
+    put_le32(buf + 12, remote_next);
+    put_le32(buf + 16, remote_ack);
+    put_le32(buf + 20, check_frame);
+    put_le32(buf + 24, check_hash);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        buf[NET_HEADER + i * 2] = local_in[(remote_ack + i) % NET_INPUTS][0];
+        buf[NET_HEADER + i * 2 + 1] = local_in[(remote_ack + i) % NET_INPUTS][1];
+    }
+    send_packet(buf, NET_HEADER + count * 2);
+    last_send = SDL_GetTicks();
+}
+
+static void compare_checks()
+{
+    if (check_frame == NET_NONE || check_frame != peer_check_frame || compared == check_frame)
+        return;
+    compared = check_frame;
+    stats.checks++;
+    if (check_hash != peer_check_hash)
+    {
+        stats.desyncs++;
+        printf("ERR: netplay desync at frame %u\n", check_frame);
+    }
+}
+
+static void receive_packets()
+{
+    uint8_t buf[NET_PACKET];
+    struct sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+    int n;
+
+    while ((n = recvfrom(sock, (char *)buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len)) > 0)
+    {
+        from_len = sizeof(from);
+        if (n < NET_HEADER || memcmp(buf, "SINP", 4) != 0 || buf[4] != NET_VERSION)
+            continue;
+        if (buf[5] != delay || get_le32(buf + 8) != rom_id)
+        {
+            if (!mismatch_reported)
+                printf("ERR: netplay peer runs another ROM or input delay\n");
+            mismatch_reported = true;
+            continue;
+        }
+        if (!has_peer)
+        {
+            peer = from;
+            has_peer = true;
+        }
+        else if (from.sin_addr.s_addr != peer.sin_addr.s_addr || from.sin_port != peer.sin_port)
+            continue;
+        uint32_t count = buf[6];
+        if ((uint32_t)n < NET_HEADER + count * 2)
+            continue;
+        stats.received++;
+        last_recv = SDL_GetTicks();
+        remote_adv = (int8_t)buf[7];
+
+        uint32_t ack = get_le32(buf + 12);
+        if (ack > remote_ack && ack <= local_next)
+            remote_ack = ack;
+        uint32_t start = get_le32(buf + 16);
+        for (uint32_t f = start; f < start + count && f <= remote_next; f++)
+        {
+            if (f < remote_next)
+                continue;
+            uint8_t *in = remote_in[f % NET_INPUTS];
+            in[0] = buf[NET_HEADER + (f - start) * 2] & remote_mask[0];
+            in[1] = buf[NET_HEADER + (f - start) * 2 + 1] & remote_mask[1];
+            last_remote[0] = in[0];
+            last_remote[1] = in[1];
+            // Frame déjà jouée sur une autre prédiction : à rejouer à partir d'elle
+            uint8_t *used = used_in[f % NET_INPUTS];
+            if (f < frame && (used[0] != in[0] || used[1] != in[1]) && f < rollback_from)
+                rollback_from = f;
+            remote_next++;
+        }
+        peer_check_frame = get_le32(buf + 20);
+        peer_check_hash = get_le32(buf + 24);
+        compare_checks();
+    }
+}
+
+// Entrées de la frame f dans les ports : les nôtres, et celles de l'autre ou leur prédiction
+static void apply_inputs(CPU *cpu, uint32_t f)
+{
+    const uint8_t *remote = f < remote_next ? remote_in[f % NET_INPUTS] : last_remote;
+    uint8_t *used = used_in[f % NET_INPUTS];
+
+    used[0] = remote[0];
+    used[1] = remote[1];
+    for (int i = 0; i < 2; i++)
+        cpu->io.latched[i] = (local_in[f % NET_INPUTS][i] & local_mask[i]) | (remote[i] & remote_mask[i]);
+}
+
+static void rollback(CPU *cpu)
+{
+    uint32_t from = rollback_from;
+    bool present, consume;
+
+    rollback_from = NET_NONE;
+    if (from >= frame)
+        return;
+    uint64_t t0 = SDL_GetPerformanceCounter();
+    get_frame_output(&present, &consume);
+    set_frame_output(false, false);
+    load_snapshot(cpu, &snaps[from % NET_SNAPS]);
+    for (uint32_t f = from; f < frame; f++)
+    {
+        if (f != from)
+            save_snapshot(cpu, &snaps[f % NET_SNAPS]);
+        apply_inputs(cpu, f);
+        while (run_emu(cpu) != EMU_END_FRAME)
+            ;
+    }
+    set_frame_output(present, consume);
+    // Le son a déjà été joué jusqu'ici : les événements rejoués sont oubliés
+    sound_seek(get_cyc(cpu), cpu->io.sound);
+
+    uint64_t ticks = SDL_GetPerformanceCounter() - t0;
+    uint32_t depth = frame - from;
+    stats.rollbacks++;
+    stats.resimulated += depth;
+    if (depth > stats.depth_max)
+        stats.depth_max = depth;
+    resim_ticks += ticks;
+    if (ticks > resim_max)
+        resim_max = ticks;
+}
+
+static uint32_t hash_memory(const Snapshot *snap)
+{
+    uint32_t hash = 0x811C9DC5;
+    const uint8_t *mem = snap->ram; // RAM puis VRAM, contiguës
+
+    for (int i = 0; i < RAM_SIZE + VRAM_SIZE; i++)
+        hash = (hash ^ mem[i]) * 0x01000193;
+    return hash;
+}
+
+// Début de frame définitif (toutes les entrées d'avant sont confirmées) : hash à comparer
+static void update_check()
+{
+    // Snapshot déjà recyclé : cette vérification est sautée
+    if (next_check + NET_SNAPS <= frame)
+        next_check += NET_CHECK_EVERY;
+    if (next_check > remote_next || next_check > frame)
+        return;
+    check_frame = next_check;
+    check_hash = hash_memory(&snaps[check_frame % NET_SNAPS]);
+    next_check += NET_CHECK_EVERY;
+    compare_checks();
+}
+
+static void poll_network(CPU *cpu)
+{
+    flush_shim();
+    receive_packets();
+    rollback(cpu);
+}
+
+// À chaque fin de frame, une fois l'entrée locale figée : corrige les frames
+// mal prédites et prépare la suivante. false si l'autre ne répond plus
+bool netplay_frame(CPU *cpu)
+{
+    uint8_t *local = local_in[(frame + delay) % NET_INPUTS];
+
+    if (sock == INVALID_SOCKET)
+        return true;
+    if (!rom_id)
+        rom_id = (uint32_t)rom_hash(cpu);
+    local[0] = cpu->io.latched[0] & local_mask[0];
+    local[1] = cpu->io.latched[1] & local_mask[1];
+    poll_network(cpu);
+
+    // Plus de snapshot pour revenir plus loin : on attend les entrées de l'autre
+    if ((int)(frame + 1 - remote_next) > NET_MAX_ROLLBACK)
+    {
+        stats.waits++;
+        while ((int)(frame + 1 - remote_next) > NET_MAX_ROLLBACK)
+        {
+            uint64_t timeout = stats.received ? NET_TIMEOUT : NET_CONNECT_TIMEOUT;
+            if (SDL_GetTicks() - last_recv > timeout)
+                return false;
+            if (SDL_GetTicks() - last_send >= NET_RESEND_MS)
+                send_inputs();
+            SDL_Delay(1);
+            poll_network(cpu);
+        }
+    }
+    // Chacun voit l'autre avec la latence du réseau : la moitié de l'écart des
+    // avances est l'avance réelle. Une frame d'attente la résorbe
+    int adv = (int)(frame - remote_next);
+    if (adv - remote_adv >= 2 && frame - last_stall > NET_MAX_ROLLBACK)
+    {
+        stats.stalls++;
+        last_stall = frame;
+        pacer_stall();
+    }
+
+    local_next = frame + delay + 1;
+    save_snapshot(cpu, &snaps[frame % NET_SNAPS]);
+    update_check();
+    apply_inputs(cpu, frame);
+    frame++;
+    stats.frames++;
+    send_inputs();
+    flush_shim();
+    return true;
+}
+
+// Avant de quitter : attend que les frames jouées soient confirmées (l'état
+// courant est alors définitif) et que l'autre ait reçu toutes nos entrées
+void netplay_finish(CPU *cpu)
+{
+    uint64_t start = SDL_GetTicks();
+
+    if (sock == INVALID_SOCKET)
+        return;
+    while (SDL_GetTicks() - start < NET_FINISH_TIMEOUT)
+    {
+        poll_network(cpu);
+        bool confirmed = remote_next >= frame;
+        bool delivered = remote_ack >= local_next || SDL_GetTicks() - last_recv > 500;
+        if (confirmed && delivered && !shim_count)
+            break;
+        if (SDL_GetTicks() - last_send >= NET_RESEND_MS)
+            send_inputs();
+        SDL_Delay(1);
+    }
+}
+
+void quit_netplay()
+{
+    if (sock != INVALID_SOCKET)
+        closesocket(sock);
+    sock = INVALID_SOCKET;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void get_net_stats(Net_Stats *out)
+{
+    double us = 1000000.0 / SDL_GetPerformanceFrequency();
+
+    *out = stats;
+    out->depth_avg = stats.rollbacks ? (double)stats.resimulated / stats.rollbacks : 0;
+    out->resim_avg_us = stats.resimulated ? resim_ticks * us / stats.resimulated : 0;
+    out->resim_max_us = resim_max * us;
+}
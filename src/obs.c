@@ -0,0 +1,147 @@
+#include "../includes/obs.h"
+
+#include <string.h>
+
+/*
+La VRAM est tournée : un octet contient 8 pixels verticaux d'une colonne.
+Pour sortir des lignes, on prend le même octet dans 8 colonnes voisines
+(une matrice 8x8 bits dans un uint64_t), on la transpose en quelques
+opérations 64 bits, et chaque octet obtenu est directement 8 pixels
+horizontaux d'une ligne (bit de poids fort = pixel de gauche).
+*/
+
+#define PACKED_ROW (OBS_W / 8)
+
+// Octet -> 8 octets 0/255, le bit de poids fort en premier
+static uint64_t gray_lut[256];
+static bool gray_lut_ready = false;
+
+static void init_gray_lut()
+{
+    for (int v = 0; v < 256; v++)
+    {
+        uint8_t px[8];
+        for (int j = 0; j < 8; j++)
+            px[j] = (v & (0x80 >> j)) ? 255 : 0;
+        memcpy(&gray_lut[v], px, 8);
+    }
+    gray_lut_ready = true;
+}
+
+// Transposée d'une matrice 8x8 bits : le bit (ligne r, colonne c) = bit 8r + c
+static inline uint64_t transpose8(uint64_t x)
+{
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+// 8 lignes de 8 pixels : colonnes x0..x0+7, octet i de chaque colonne.
+// L'octet b du résultat est la ligne écran OBS_H - 1 - (8i + b).
+static inline uint64_t block8(const uint8_t *vram, int x0, int i)
+{
+    uint64_t m = 0;
+    const uint8_t *p = vram + x0 * 32 + i;
+    // La colonne x0 + k va dans l'octet 7 - k pour finir en bit de poids fort
+    for (int k = 0; k < 8; k++)
+        m |= (uint64_t)p[k * 32] << (8 * (7 - k));
+    return transpose8(m);
+}
+
+// Image 1bpp OBS_W x OBS_H, lignes de OBS_W / 8 octets, bit de poids fort = pixel de gauche
+void obs_packed(const uint8_t *vram, uint8_t *out)
+{
+    for (int x0 = 0; x0 < OBS_W; x0 += 8)
+    {
+        for (int i = 0; i < 32; i++)
+        {
+            uint64_t rows = block8(vram, x0, i);
+            uint8_t *dst = out + (OBS_H - 1 - 8 * i) * PACKED_ROW + x0 / 8;
+            for (int b = 0; b < 8; b++, dst -= PACKED_ROW)
+                *dst = (uint8_t)(rows >> (8 * b));
+        }
+    }
+}
+
+// Image OBS_W x OBS_H, un octet par pixel : 0 ou 255
+void obs_gray(const uint8_t *vram, uint8_t *out)
+{
+    if (!gray_lut_ready)
+        init_gray_lut();
+    for (int x0 = 0; x0 < OBS_W; x0 += 8)
+    {
+        for (int i = 0; i < 32; i++)
+        {
+            uint64_t rows = block8(vram, x0, i);
+            uint8_t *dst = out + (OBS_H - 1 - 8 * i) * OBS_W + x0;
+            for (int b = 0; b < 8; b++, dst -= OBS_W)
+                memcpy(dst, &gray_lut[(rows >> (8 * b)) & 0xFF], 8);
+        }
+    }
+}
+
+// Max-pooling vers ow x oh (0/255) : un pixel de sortie est allumé si un pixel
+// de sa zone source l'est. Les lignes d'une zone sont combinées par OU 64 bits.
+int obs_pooled(const uint8_t *vram, uint8_t *out, int ow, int oh)
+{
+    uint8_t packed[OBS_PACKED_SIZE];
+    uint64_t acc[(PACKED_ROW + 7) / 8];
+    uint32_t zone[OBS_W]; // Colonnes source de chaque pixel de sortie : octet de départ + masque 24 bits
+    bool narrow = true;
+
+    if (ow <= 0 || oh <= 0 || ow > OBS_W || oh > OBS_H)
+        return -1;
+    obs_packed(vram, packed);
+
+    // Une zone de 17 colonnes au plus tient dans 3 octets quel que soit son alignement
+    for (int ox = 0; ox < ow; ox++)
+    {
+        int x0 = ox * OBS_W / ow;
+        int x1 = ((ox + 1) * OBS_W + ow - 1) / ow;
+        if (x1 - x0 > 17)
+            narrow = false;
+        else
+            zone[ox] = (uint32_t)(x0 / 8) << 24 | ((0xFFFFFFu << (24 - (x1 - x0))) & 0xFFFFFFu) >> (x0 % 8);
+    }
+
+    for (int oy = 0; oy < oh; oy++)
+    {
+        int y0 = oy * OBS_H / oh;
+        int y1 = ((oy + 1) * OBS_H + oh - 1) / oh;
+
+        memset(acc, 0, sizeof(acc));
+        for (int y = y0; y < y1; y++)
+        {
+            uint64_t row[(PACKED_ROW + 7) / 8] = { 0 };
+            memcpy(row, packed + y * PACKED_ROW, PACKED_ROW);
+            for (size_t k = 0; k < sizeof(acc) / sizeof(acc[0]); k++)
+                acc[k] |= row[k];
+        }
+
+        uint8_t bits[sizeof(acc) + 3] = { 0 };
+        memcpy(bits, acc, sizeof(acc));
+        for (int ox = 0; ox < ow; ox++)
+        {
+            uint8_t v = 0;
+            if (narrow)
+            {
+                const uint8_t *p = bits + (zone[ox] >> 24);
+                uint32_t window = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+                v = (window & zone[ox] & 0xFFFFFFu) != 0;
+            }
+            else
+            {
+                // Zones de plus de 17 colonnes (ow très petit) : bit par bit
+                for (int x = ox * OBS_W / ow; x < ((ox + 1) * OBS_W + ow - 1) / ow && !v; x++)
+                    v = (bits[x / 8] >> (7 - x % 8)) & 1;
+            }
+            out[oy * ow + ox] = v ? 255 : 0;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include "../includes/overlay.h"
+#include "../includes/video.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+Les bandes de cellophane collées sur l'écran de la borne :
+ - rouge en haut pour la soucoupe (UFO)
+ - vert en bas pour les boucliers et le joueur
+Le profil est appliqué ligne par ligne pendant l'expansion des bits,
+il ne coûte donc aucune passe en plus sur le framebuffer.
+
+Format d'un fichier de profil (une bande par ligne, # pour les commentaires) :
+    <première ligne> <dernière ligne> <RRGGBB>
+*/
+
+#define MAX_BANDS H
+
+static const Overlay_Band cabinet_bands[] = {
+    { 32,  63,  0xFFFF2020u }, // UFO
+    { 184, 239, 0xFF20FF20u }, // Boucliers et joueur
+    { 240, 255, 0xFF20FF20u }, // Vies restantes
+};
+
+static uint32_t row_color[H];
+static Overlay_Band bands[MAX_BANDS];
+static int nb_bands = 0;
+static bool mono = true;
+
+// Regroupe les lignes consécutives de même couleur (utilisé par les textures natives)
+static void build_bands()
+{
+    nb_bands = 0;
+    mono = true;
+    for (int y = 0; y < H; y++)
+    {
+        if (row_color[y] != 0xFFFFFFFFu)
+            mono = false;
+        if (nb_bands && bands[nb_bands - 1].color == row_color[y])
+            bands[nb_bands - 1].last = y;
+        else
+            bands[nb_bands++] = (Overlay_Band){ y, y, row_color[y] };
+    }
+}
+
+static void reset_rows()
+{
+    for (int y = 0; y < H; y++)
+        row_color[y] = 0xFFFFFFFFu;
+}
+
+static void apply_band(Overlay_Band band)
+{
+    if (band.first < 0)
+        band.first = 0;
+    if (band.last >= H)
+        band.last = H - 1;
+    for (int y = band.first; y <= band.last; y++)
+        row_color[y] = band.color;
+}
+
+static int load_overlay_file(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror("Error fopen overlay:");
+        return -1;
+    }
+
+    char line[128];
+    int nb_line = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        nb_line++;
+        Overlay_Band band;
+        unsigned int rgb;
+        if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0')
+            continue;
+        if (sscanf(line, "%d %d %x", &band.first, &band.last, &rgb) != 3)
+        {
+            printf("ERR: overlay %s line %d is invalid\n", path, nb_line);
+            fclose(f);
+            return -1;
+        }
+        band.color = 0xFF000000u | (rgb & 0xFFFFFF);
+        apply_band(band);
+    }
+    fclose(f);
+    return 0;
+}
+
+// profile: "mono", "cabinet" ou le chemin d'un fichier de profil
+int load_overlay(const char *profile)
+{
+    int ret = 0;
+
+    reset_rows();
+    if (!profile || strcmp(profile, "mono") == 0)
+        ;
+    else if (strcmp(profile, "cabinet") == 0)
+    {
+        for (size_t i = 0; i < sizeof(cabinet_bands) / sizeof(cabinet_bands[0]); i++)
+            apply_band(cabinet_bands[i]);
+    }
+    else if ((ret = load_overlay_file(profile)) != 0)
+        reset_rows();
+    build_bands();
+    return ret;
+}
+
+// Couleur ARGB des pixels allumés pour chaque ligne de l'écran (H entrées)
+const uint32_t *get_overlay_rows()
+{
+    if (!nb_bands)
+        load_overlay(NULL);
+    return row_color;
+}
+
+int get_overlay_bands(const Overlay_Band **out)
+{
+    if (!nb_bands)
+        load_overlay(NULL);
+    *out = bands;
+    return nb_bands;
+}
+
+bool overlay_is_mono()
+{
+    return mono;
+}
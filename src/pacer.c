@@ -0,0 +1,220 @@
+#include "../includes/pacer.h"
+#include "../includes/frame.h"
+#include "../includes/sound.h"
+#include "../includes/cpu8080.h"
+
+#include <string.h>
+#include <../includes/SDL3/SDL.h>
+
+/*
+Contrôleur de rythme. Chaque frame a une échéance (période = 1 / hz) sur
+l'horloge haute résolution. En avance, on dort jusqu'à l'échéance. En retard
+de plus d'une période, la frame suivante est émulée sans être affichée pour
+rattraper (jamais plus de PACER_MAX_SKIP de suite) : l'émulation, elle, n'est
+jamais sautée. Trop en retard, l'échéance est recalée sur maintenant.
+
+En mode audio, il n'y a pas d'échéance : on attend que la carte son ait
+ramené la file sous la cible. La vitesse d'émulation est alors exactement
+celle du périphérique, la correction de ratio de sound.c absorbe le reste.
+
+En turbo, quel que soit le mode, on n'attend plus rien : l'émulation va aussi
+vite que l'hôte, et seule une frame sur turbo_every est affichée pour que
+l'affichage ne devienne pas le goulot.
+*/
+
+#define PACER_MAX_LATE 8 // En périodes, au-delà on abandonne le rattrapage
+#define PACER_AUDIO_POLL 500000 // ns entre deux lectures du remplissage audio
+
+static Pacing_Mode mode = PACING_OFF;
+static uint64_t freq;
+static uint64_t period;
+static uint64_t deadline;
+static uint64_t frame_start;
+static uint64_t first_start;
+static int skip_run = 0;
+static uint32_t audio_low; // Mode audio : niveau sous lequel la frame suivante peut partir
+static bool turbo = false;
+static int turbo_every = PACER_TURBO_EVERY;
+static int turbo_count = 0;
+
+static uint64_t speed_start;
+static uint64_t speed_cyc;
+static uint32_t speed_frames = 0;
+static bool speed_updated = false;
+static Pacer_Speed speed;
+
+static uint32_t frames, presented, skipped, late;
+static uint64_t cost_min = UINT64_MAX, cost_max = 0, cost_total = 0;
+
+static const struct { const char *name; Pacing_Mode mode; } pacing_names[] = {
+    { "off",   PACING_OFF },
+    { "vsync", PACING_VSYNC },
+    { "timer", PACING_TIMER },
+    { "audio", PACING_AUDIO },
+};
+
+int parse_pacing(const char *name, Pacing_Mode *out)
+{
+    for (size_t i = 0; i < sizeof(pacing_names) / sizeof(pacing_names[0]); i++)
+    {
+        if (strcmp(name, pacing_names[i].name) == 0)
+        {
+            *out = pacing_names[i].mode;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void init_pacer(Pacing_Mode m, double hz, uint64_t cyc)
+{
+    mode = m;
+    freq = SDL_GetPerformanceFrequency();
+    period = (uint64_t)(freq / (hz > 0 ? hz : PACER_DEFAULT_HZ));
+    frame_start = first_start = speed_start = SDL_GetPerformanceCounter();
+    speed_cyc = cyc;
+    deadline = frame_start + period;
+    // Une frame ajoute SOUND_RATE / hz échantillons : centrés autour de la cible
+    uint32_t half_frame = (uint32_t)(SOUND_RATE / (2 * (hz > 0 ? hz : PACER_DEFAULT_HZ)));
+    audio_low = get_sound_target() > half_frame ? get_sound_target() - half_frame : 0;
+}
+
+Pacing_Mode get_pacing()
+{
+    return mode;
+}
+
+// n: frames émulées par frame affichée en turbo
+int set_turbo_every(int n)
+{
+    if (n < 1 || n > PACER_TURBO_MAX)
+        return -1;
+    turbo_every = n;
+    return 0;
+}
+
+void set_turbo(bool on)
+{
+    turbo = on;
+    turbo_count = 0;
+    // Au retour, l'échéance repart de maintenant et tout est de nouveau affiché
+    if (!on)
+    {
+        deadline = SDL_GetPerformanceCounter() + period;
+        skip_run = 0;
+        set_present_skip(false);
+    }
+}
+
+bool get_turbo()
+{
+    return turbo;
+}
+
+static void update_speed(uint64_t now, uint64_t cyc)
+{
+    speed_frames++;
+    if (now - speed_start < freq / 2)
+        return;
+    double seconds = (double)(now - speed_start) / freq;
+    // Signé : le rewind fait reculer l'horloge émulée
+    double cycles = (double)(int64_t)(cyc - speed_cyc);
+    speed.fps = speed_frames / seconds;
+    speed.mhz = cycles / seconds / 1000000.0;
+    speed.factor = cycles / seconds / CPU_CLOCK;
+    speed_updated = true;
+    speed_start = now;
+    speed_cyc = cyc;
+    speed_frames = 0;
+}
+
+// Appelé juste après chaque fin de frame (et donc après l'éventuel affichage)
+void pacer_end_frame(uint64_t cyc)
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+    uint64_t cost = now - frame_start;
+
+    frames++;
+    cost_total += cost;
+    if (cost < cost_min)
+        cost_min = cost;
+    if (cost > cost_max)
+        cost_max = cost;
+    if (is_present_skipped())
+        skipped++;
+    else
+        presented++;
+
+    if (turbo)
+    {
+        turbo_count = (turbo_count + 1) % turbo_every;
+        set_present_skip(turbo_count != 0);
+    }
+    else if (mode == PACING_TIMER)
+    {
+        if (now < deadline)
+        {
+            SDL_DelayPrecise((deadline - now) * 1000000000ull / freq);
+            set_present_skip(false);
+            skip_run = 0;
+        }
+        else
+        {
+            late++;
+            if (now - deadline > PACER_MAX_LATE * period)
+                deadline = now; // Hôte bien trop lent : on repart d'ici
+            // Plus d'une période de retard : la prochaine frame ne sera pas affichée
+            bool skip = now - deadline > period && skip_run < PACER_MAX_SKIP;
+            skip_run = skip ? skip_run + 1 : 0;
+            set_present_skip(skip);
+        }
+        deadline += period;
+    }
+    else if (mode == PACING_AUDIO)
+    {
+        // File déjà basse dès la fin de frame : la carte a faim, on est en retard
+        if (get_sound_queued() <= audio_low)
+            late++;
+        // Borné, au cas où le périphérique s'arrête de consommer
+        while (get_sound_queued() > audio_low
+            && SDL_GetPerformanceCounter() - now < PACER_MAX_LATE * period)
+            SDL_DelayPrecise(PACER_AUDIO_POLL);
+    }
+    frame_start = SDL_GetPerformanceCounter();
+    update_speed(frame_start, cyc);
+}
+
+// Retient l'émulation une période (netplay en avance sur l'autre machine).
+// En mode timer, c'est l'échéance qui recule : dormir ici serait rattrapé
+void pacer_stall()
+{
+    if (mode == PACING_TIMER && !turbo)
+        deadline += period;
+    else
+        SDL_DelayPrecise(period * 1000000000ull / freq);
+}
+
+// true si une nouvelle mesure est disponible depuis le dernier appel
+bool get_pacer_speed(Pacer_Speed *out)
+{
+    bool updated = speed_updated;
+
+    *out = speed;
+    speed_updated = false;
+    return updated;
+}
+
+void get_pacer_stats(Pacer_Stats *stats)
+{
+    double us = 1000000.0 / freq;
+    uint64_t elapsed = SDL_GetPerformanceCounter() - first_start;
+
+    stats->frames = frames;
+    stats->presented = presented;
+    stats->skipped = skipped;
+    stats->late = late;
+    stats->cost_min_us = frames ? cost_min * us : 0;
+    stats->cost_avg_us = frames ? cost_total * us / frames : 0;
+    stats->cost_max_us = cost_max * us;
+    stats->fps = elapsed ? frames * (double)freq / elapsed : 0;
+}
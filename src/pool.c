@@ -0,0 +1,114 @@
+#include "../includes/pool.h"
+
+#include <../includes/SDL3/SDL.h>
+
+/*
+Petit pool de threads : pool_run() réveille les workers, le thread appelant
+travaille avec eux, et chacun prend la tâche suivante avec un compteur atomique
+jusqu'à ce qu'il n'y en ait plus. pool_run() ne rend la main qu'une fois tout fini.
+*/
+
+static SDL_Thread *workers[MAX_WORKERS];
+static int nb_workers = 0;
+static SDL_Semaphore *start_sem = NULL;
+static SDL_Semaphore *done_sem = NULL;
+static SDL_AtomicInt next_task;
+static SDL_AtomicInt quit;
+
+static Pool_Job cur_job;
+static void *cur_user;
+static int cur_nb_tasks;
+
+static void run_tasks()
+{
+    int task;
+    while ((task = SDL_AddAtomicInt(&next_task, 1)) < cur_nb_tasks)
+        cur_job(cur_user, task);
+}
+
+static int worker(void *data)
+{
+    (void)data;
+    while (1)
+    {
+        SDL_WaitSemaphore(start_sem);
+        if (SDL_GetAtomicInt(&quit))
+            break;
+        run_tasks();
+        SDL_SignalSemaphore(done_sem);
+    }
+    return 0;
+}
+
+// nb_threads compte le thread appelant : 1 = pas de worker, <= 0 = un par coeur
+int init_pool(int nb_threads)
+{
+    if (nb_workers)
+        return 0;
+    if (nb_threads <= 0)
+        nb_threads = SDL_GetNumLogicalCPUCores();
+    if (nb_threads > MAX_WORKERS + 1)
+        nb_threads = MAX_WORKERS + 1;
+    if (nb_threads <= 1)
+        return 0;
+
+    start_sem = SDL_CreateSemaphore(0);
+    done_sem = SDL_CreateSemaphore(0);
+    if (!start_sem || !done_sem)
+    {
+        SDL_Log("CreateSemaphore: %s", SDL_GetError());
+        return 1;
+    }
+    SDL_SetAtomicInt(&quit, 0);
+    for (int i = 0; i < nb_threads - 1; i++)
+    {
+        workers[i] = SDL_CreateThread(worker, "pool", NULL);
+        if (!workers[i])
+        {
+            SDL_Log("CreateThread: %s", SDL_GetError());
+            break;
+        }
+        nb_workers++;
+    }
+    return 0;
+}
+
+int get_pool_size()
+{
+    return nb_workers + 1;
+}
+
+void pool_run(Pool_Job job, void *user, int nb_tasks)
+{
+    if (!nb_workers)
+    {
+        for (int task = 0; task < nb_tasks; task++)
+            job(user, task);
+        return;
+    }
+
+    // Les sémaphores servent de barrière : les workers voient bien la nouvelle tâche
+    cur_job = job;
+    cur_user = user;
+    cur_nb_tasks = nb_tasks;
+    SDL_SetAtomicInt(&next_task, 0);
+    for (int i = 0; i < nb_workers; i++)
+        SDL_SignalSemaphore(start_sem);
+    run_tasks();
+    for (int i = 0; i < nb_workers; i++)
+        SDL_WaitSemaphore(done_sem);
+}
+
+void quit_pool()
+{
+    if (!nb_workers)
+        return;
+    SDL_SetAtomicInt(&quit, 1);
+    for (int i = 0; i < nb_workers; i++)
+        SDL_SignalSemaphore(start_sem);
+    for (int i = 0; i < nb_workers; i++)
+        SDL_WaitThread(workers[i], NULL);
+    nb_workers = 0;
+    SDL_DestroySemaphore(start_sem);
+    SDL_DestroySemaphore(done_sem);
+}
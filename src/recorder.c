@@ -0,0 +1,346 @@
+#include "../includes/recorder.h"
+#include "../includes/frame.h"
+#include "../includes/memory.h"
+#include "../includes/ring.h"
+#include "../includes/video.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+Enregistreur de frames. Le thread de l'émulation ne fait qu'une copie de la
+VRAM (7 Ko) dans une file sans verrou ; un thread d'écriture la vide et encode
+sur disque. Si la file est pleine, la politique décide : perdre la frame ou
+attendre que le thread d'écriture ait fait de la place.
+*/
+
+#define PNG_ROW (1 + W / 8) // Octet de filtre + 1 bit par pixel
+
+typedef struct Rec_Frame
+{
+    uint32_t number;
+    uint64_t cyc;
+    uint8_t vram[VRAM_SIZE];
+} Rec_Frame;
+
+static Ring queue;
+static uint32_t queue_len = 0; // Frames au plus dans la file, même si le tampon arrondi en tient plus
+static SDL_Thread *writer = NULL;
+static SDL_Semaphore *data_sem = NULL;  // Une frame vient d'être ajoutée
+static SDL_Semaphore *space_sem = NULL; // Une frame vient d'être retirée (REC_BLOCK)
+static SDL_AtomicInt stopping;
+static SDL_AtomicInt written;
+static SDL_AtomicInt dropped;
+static uint32_t max_depth = 0;
+static uint32_t skipped = 0;
+static bool dedup = false;
+static bool queued_once = false;
+static uint64_t queued_hash = 0; // Dernière frame réellement mise en file
+
+static Rec_Format format;
+static Rec_Policy policy;
+static char path[512];
+static FILE *out = NULL;
+
+static const struct { const char *name; Rec_Format format; } format_names[] = {
+    { "y4m", REC_Y4M },
+    { "raw", REC_RAW },
+    { "png", REC_PNG },
+};
+
+int parse_rec_format(const char *name, Rec_Format *fmt)
+{
+    for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); i++)
+    {
+        if (strcmp(name, format_names[i].name) == 0)
+        {
+            *fmt = format_names[i].format;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Pixel (x, y) de l'écran affiché, à partir de la VRAM non tournée
+static inline int vram_pixel(const uint8_t *vram, int x, int y)
+{
+    int n = H - 1 - y;
+    return (vram[x * 32 + n / 8] >> (n % 8)) & 1;
+}
+
+static void write_y4m(const Rec_Frame *rec)
+{
+    static uint8_t luma[W * H];
+
+    // Parcours dans l'ordre de la VRAM : une colonne de l'écran, de bas en haut
+    for (int x = 0; x < W; x++)
+    {
+        uint8_t *px = luma + (H - 1) * W + x;
+        for (int i = 0; i < 32; i++)
+        {
+            uint8_t current_byte = rec->vram[x * 32 + i];
+            for (int bit = 0; bit < 8; bit++, px -= W)
+                *px = ((current_byte >> bit) & 1) ? 235 : 16;
+        }
+    }
+    fputs("FRAME\n", out);
+    fwrite(luma, 1, sizeof(luma), out);
+}
+
+static uint32_t crc_table[256];
+
+static void init_crc_table()
+{
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void write_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+    uint8_t hdr[8];
+    uint8_t crc_buf[4];
+
+    put_be32(hdr, len);
+    memcpy(hdr + 4, type, 4);
+    fwrite(hdr, 1, 8, f);
+    fwrite(data, 1, len, f);
+    put_be32(crc_buf, crc32(crc32(0, hdr + 4, 4), data, len));
+    fwrite(crc_buf, 1, 4, f);
+}
+
+// PNG gris 1 bit, données zlib en un bloc "stored" (pas de compression, pas de dépendance)
+static void write_png(const Rec_Frame *rec)
+{
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    static uint8_t idat[2 + 5 + PNG_ROW * H + 4];
+    uint8_t ihdr[13] = { 0 };
+    char name[600];
+    uint8_t *raw = idat + 7;
+    uint32_t len = PNG_ROW * H;
+    uint32_t a = 1, b = 0;
+
+    snprintf(name, sizeof(name), "%s_%06u.png", path, rec->number);
+    FILE *f = fopen(name, "wb");
+    if (!f)
+    {
+        perror("Error fopen png:");
+        return;
+    }
+
+    memset(raw, 0, len);
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++)
+            if (vram_pixel(rec->vram, x, y))
+                raw[y * PNG_ROW + 1 + x / 8] |= 0x80 >> (x % 8);
+    for (uint32_t i = 0; i < len; i++)
+    {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    idat[0] = 0x78; // zlib, deflate
+    idat[1] = 0x01;
+    idat[2] = 0x01; // Dernier bloc, non compressé
+    idat[3] = len & 0xFF;
+    idat[4] = len >> 8;
+    idat[5] = ~len & 0xFF;
+    idat[6] = (~len >> 8) & 0xFF;
+    put_be32(idat + 7 + len, (b << 16) | a);
+
+    put_be32(ihdr, W);
+    put_be32(ihdr + 4, H);
+    ihdr[8] = 1; // 1 bit par pixel
+    ihdr[9] = 0; // Niveaux de gris
+    fwrite(signature, 1, sizeof(signature), f);
+    write_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    write_chunk(f, "IDAT", idat, sizeof(idat));
+    write_chunk(f, "IEND", NULL, 0);
+    fclose(f);
+}
+
+static void write_frame(const Rec_Frame *rec)
+{
+    switch (format)
+    {
+        case REC_Y4M:
+            write_y4m(rec);
+            break;
+        case REC_RAW:
+            fwrite(rec->vram, 1, VRAM_SIZE, out);
+            break;
+        case REC_PNG:
+            write_png(rec);
+            break;
+    }
+}
+
+static int writer_thread(void *data)
+{
+    static Rec_Frame rec;
+    (void)data;
+
+    while (1)
+    {
+        SDL_WaitSemaphoreTimeout(data_sem, 100);
+        while (ring_pop(&queue, &rec, sizeof(rec)))
+        {
+            if (policy == REC_BLOCK)
+                SDL_SignalSemaphore(space_sem);
+            write_frame(&rec);
+            SDL_AddAtomicInt(&written, 1);
+        }
+        if (SDL_GetAtomicInt(&stopping) && ring_used(&queue) == 0)
+            break;
+    }
+    return 0;
+}
+
+// Consommateur de frames : appelé par submit_frame() sur le thread de l'émulation
+static void record_frame(const Frame *frame, void *user)
+{
+    static Rec_Frame rec;
+    (void)user;
+
+    // Même hash que la dernière frame mise en file : rien de nouveau à écrire.
+    // Pas frame->changed : une frame perdue sur file pleine doit repasser ensuite
+    if (dedup && queued_once && frame->hash == queued_hash)
+    {
+        skipped++;
+        return;
+    }
+    rec.number = frame->number;
+    rec.cyc = frame->cyc;
+    memcpy(rec.vram, frame->vram, VRAM_SIZE);
+    while (ring_used(&queue) / sizeof(rec) >= queue_len || !ring_push(&queue, &rec, sizeof(rec)))
+    {
+        if (policy == REC_DROP)
+        {
+            SDL_AddAtomicInt(&dropped, 1);
+            return;
+        }
+        SDL_WaitSemaphoreTimeout(space_sem, 10);
+    }
+    SDL_SignalSemaphore(data_sem);
+    queued_once = true;
+    queued_hash = frame->hash;
+
+    uint32_t depth = ring_used(&queue) / sizeof(Rec_Frame);
+    if (depth > max_depth)
+        max_depth = depth;
+}
+
+// Arrête le thread d'écriture (après la file) et libère tout ce qui a été ouvert
+static void release_recorder()
+{
+    if (writer)
+    {
+        SDL_SetAtomicInt(&stopping, 1);
+        SDL_SignalSemaphore(data_sem);
+        SDL_WaitThread(writer, NULL);
+        writer = NULL;
+    }
+    if (out)
+        fclose(out);
+    out = NULL;
+    free_ring(&queue);
+    if (data_sem)
+        SDL_DestroySemaphore(data_sem);
+    if (space_sem)
+        SDL_DestroySemaphore(space_sem);
+    data_sem = NULL;
+    space_sem = NULL;
+}
+
+// dedup: les frames identiques à la précédente ne sont pas écrites. Les PNG gardent
+// le numéro de frame dans leur nom ; en y4m et raw la durée n'est plus conservée.
+int start_recorder(const char *file, Rec_Format fmt, Rec_Policy pol, int queue_frames, bool dd)
+{
+    if (writer)
+        return -1;
+    format = fmt;
+    policy = pol;
+    dedup = dd;
+    snprintf(path, sizeof(path), "%s", file);
+    if (queue_frames < 1)
+        queue_frames = 1;
+
+    if (format == REC_PNG)
+        init_crc_table();
+    else
+    {
+        out = fopen(path, "wb");
+        if (!out)
+        {
+            perror("Error fopen record:");
+            return -1;
+        }
+        if (format == REC_Y4M)
+            fprintf(out, "YUV4MPEG2 W%d H%d F60000:1001 Ip A1:1 Cmono\n", W, H);
+    }
+
+    queue_len = queue_frames;
+    data_sem = SDL_CreateSemaphore(0);
+    space_sem = SDL_CreateSemaphore(0);
+    SDL_SetAtomicInt(&stopping, 0);
+    SDL_SetAtomicInt(&written, 0);
+    SDL_SetAtomicInt(&dropped, 0);
+    max_depth = 0;
+    skipped = 0;
+    queued_once = false;
+    if (init_ring(&queue, queue_frames * sizeof(Rec_Frame)) != 0 || !data_sem || !space_sem)
+    {
+        release_recorder();
+        return -1;
+    }
+    writer = SDL_CreateThread(writer_thread, "recorder", NULL);
+    if (!writer)
+    {
+        SDL_Log("CreateThread: %s", SDL_GetError());
+        release_recorder();
+        return -1;
+    }
+    if (add_frame_consumer(record_frame, NULL) != 0)
+    {
+        release_recorder();
+        return -1;
+    }
+    return 0;
+}
+
+// Vide la file sur le disque puis arrête le thread d'écriture
+void stop_recorder()
+{
+    if (!writer)
+        return;
+    remove_frame_consumer(record_frame, NULL);
+    release_recorder();
+}
+
+void get_recorder_stats(Recorder_Stats *stats)
+{
+    stats->depth = writer ? ring_used(&queue) / sizeof(Rec_Frame) : 0;
+    stats->max_depth = max_depth;
+    stats->written = SDL_GetAtomicInt(&written);
+    stats->dropped = SDL_GetAtomicInt(&dropped);
+    stats->skipped = skipped;
+}
@@ -0,0 +1,290 @@
+#include "../includes/rewind.h"
+#include "../includes/snapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <../includes/SDL3/SDL.h>
+
+/*
+Retour en arrière. Chaque frame, la machine est capturée dans un tampon
+circulaire de taille fixe : les registres tels quels, et la RAM + VRAM (8 Ko)
+sous forme de XOR avec la frame précédente, compressé par plages (RLE). Toutes
+les REWIND_KEYFRAME frames, la mémoire est en plus gardée entière.
+
+Le XOR marche dans les deux sens : en partant de l'état courant, appliquer le
+delta de la frame n redonne la frame n - 1. Reculer ne coûte donc qu'un delta
+par frame, et une image complète recale tout à chaque keyframe. Quand le
+tampon est plein, les frames les plus anciennes sont perdues.
+*/
+
+#define MEM_SIZE (RAM_SIZE + VRAM_SIZE)
+#define DELTA_BUDGET 1024 // Octets prévus par frame pour dimensionner le tampon
+#define MIN_RUN 4         // Égalités à partir desquelles on coupe un littéral
+
+_Static_assert(offsetof(Snapshot, vram) == offsetof(Snapshot, ram) + RAM_SIZE, "ram et vram contiguës");
+
+// Tout l'état sauf la mémoire, copié tel quel dans chaque entrée
+typedef struct Rewind_Regs
+{
+    uint8_t regs[CPU_REGS_SIZE];
+    Cpu_Clock clock;
+    Io_State io;
+} Rewind_Regs;
+
+typedef struct Entry
+{
+    uint32_t offset; // Dans pool
+    uint32_t len;
+    bool key;
+} Entry;
+
+static uint8_t *pool = NULL;
+static uint32_t pool_size = 0;
+static uint32_t pool_head = 0; // Fin de l'entrée la plus récente
+static Entry *entries = NULL;
+static uint32_t nb_max = 0;
+static uint32_t first = 0;     // Plus ancienne entrée
+static uint32_t count = 0;
+static uint32_t since_key = 0;
+static uint8_t prev_mem[MEM_SIZE]; // Mémoire de l'entrée la plus récente
+static Snapshot snap;
+
+static uint64_t delta_total = 0;
+static uint32_t nb_deltas = 0;
+static uint64_t capture_ticks = 0;
+static uint32_t nb_captures = 0;
+
+int init_rewind(int seconds)
+{
+    quit_rewind();
+    if (seconds <= 0)
+        return 0;
+    nb_max = seconds * 60 + 1;
+    pool_size = nb_max * DELTA_BUDGET + 2 * (sizeof(Rewind_Regs) + MEM_SIZE);
+    pool = malloc(pool_size);
+    entries = malloc(nb_max * sizeof(Entry));
+    if (!pool || !entries)
+    {
+        quit_rewind();
+        return -1;
+    }
+    return 0;
+}
+
+void quit_rewind()
+{
+    free(pool);
+    free(entries);
+    pool = NULL;
+    entries = NULL;
+    pool_head = first = count = since_key = 0;
+}
+
+bool rewind_enabled()
+{
+    return pool != NULL;
+}
+
+static uint8_t *put_varint(uint8_t *o, uint32_t v)
+{
+    while (v > 0x7F)
+    {
+        *o++ = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    *o++ = v;
+    return o;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, uint32_t *v)
+{
+    uint32_t r = 0;
+    for (int shift = 0; ; shift += 7)
+    {
+        uint8_t b = *p++;
+        r |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            break;
+    }
+    *v = r;
+    return p;
+}
+
+static inline uint64_t load64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+// Suites de (octets identiques, octets différents + leur XOR). Rien après le dernier littéral
+static uint32_t encode_delta(const uint8_t *cur, const uint8_t *prev, uint8_t *out)
+{
+    uint8_t *o = out;
+    uint32_t i = 0;
+
+    while (i < MEM_SIZE)
+    {
+        uint32_t start = i;
+        while (i + 8 <= MEM_SIZE && load64(cur + i) == load64(prev + i))
+            i += 8;
+        while (i < MEM_SIZE && cur[i] == prev[i])
+            i++;
+        if (i == MEM_SIZE)
+            break;
+        uint32_t lit = i;
+        while (i < MEM_SIZE)
+        {
+            if (cur[i] != prev[i])
+            {
+                i++;
+                continue;
+            }
+            uint32_t j = i;
+            while (j < MEM_SIZE && j - i < MIN_RUN && cur[j] == prev[j])
+                j++;
+            if (j - i >= MIN_RUN || j == MEM_SIZE)
+                break;
+            i = j;
+        }
+        o = put_varint(o, lit - start);
+        o = put_varint(o, i - lit);
+        for (uint32_t k = lit; k < i; k++)
+            *o++ = cur[k] ^ prev[k];
+    }
+    return o - out;
+}
+
+static void apply_delta(uint8_t *mem, const uint8_t *p, const uint8_t *end)
+{
+    uint32_t pos = 0;
+
+    while (p < end)
+    {
+        uint32_t zeros, lit;
+        p = get_varint(p, &zeros);
+        p = get_varint(p, &lit);
+        pos += zeros;
+        for (uint32_t k = 0; k < lit; k++)
+            mem[pos++] ^= *p++;
+    }
+}
+
+static inline Entry *entry_at(uint32_t i)
+{
+    return &entries[(first + i) % nb_max];
+}
+
+static void drop_oldest()
+{
+    first = (first + 1) % nb_max;
+    count--;
+}
+
+// Place pour len octets à la suite de la dernière entrée, quitte à oublier les plus anciennes.
+// Les entrées sont rangées dans l'ordre : après pool_head, il n'y a que les plus anciennes
+static uint32_t alloc(uint32_t len)
+{
+    uint32_t pos = pool_head;
+
+    if (pos + len > pool_size)
+    {
+        // On repart du début : la fin du tampon est abandonnée avec ce qu'elle contient
+        while (count && entry_at(0)->offset >= pool_head)
+            drop_oldest();
+        pos = 0;
+    }
+    while (count)
+    {
+        Entry *old = entry_at(0);
+        bool overlap = old->offset < pos + len && pos < old->offset + old->len;
+        if (!overlap && count < nb_max)
+            break;
+        drop_oldest();
+    }
+    pool_head = pos + len;
+    return pos;
+}
+
+void rewind_capture(const CPU *cpu)
+{
+    static uint8_t delta[MEM_SIZE + 64];
+    uint64_t t0 = SDL_GetPerformanceCounter();
+    Rewind_Regs regs;
+
+    if (!pool)
+        return;
+    save_snapshot(cpu, &snap);
+    memcpy(regs.regs, snap.regs, CPU_REGS_SIZE);
+    regs.clock = snap.clock;
+    regs.io = snap.io;
+
+    // Le delta est toujours gardé, keyframe ou pas : c'est lui qui permet de reculer
+    const uint8_t *mem = snap.ram;
+    uint32_t delta_len = encode_delta(mem, prev_mem, delta);
+    bool key = count == 0 || since_key + 1 >= REWIND_KEYFRAME || delta_len >= MEM_SIZE;
+    uint32_t len = sizeof(regs) + (key ? MEM_SIZE : 0) + delta_len;
+
+    uint32_t pos = alloc(len);
+    uint8_t *p = pool + pos;
+    memcpy(p, &regs, sizeof(regs));
+    p += sizeof(regs);
+    if (key)
+    {
+        memcpy(p, mem, MEM_SIZE);
+        p += MEM_SIZE;
+    }
+    memcpy(p, delta, delta_len);
+    *entry_at(count) = (Entry){ pos, len, key };
+    count++;
+    since_key = key ? 0 : since_key + 1;
+    memcpy(prev_mem, mem, MEM_SIZE);
+
+    delta_total += delta_len;
+    nb_deltas++;
+    capture_ticks += SDL_GetPerformanceCounter() - t0;
+    nb_captures++;
+}
+
+// Recule d'une frame. Renvoie false s'il n'y a plus rien avant
+bool rewind_step(CPU *cpu)
+{
+    Rewind_Regs regs;
+
+    if (!pool || count < 2)
+        return false;
+
+    // Le delta de la frame courante, réappliqué, redonne la mémoire de la précédente
+    Entry *cur = entry_at(count - 1);
+    Entry *prev = entry_at(count - 2);
+    const uint8_t *delta = pool + cur->offset + sizeof(Rewind_Regs) + (cur->key ? MEM_SIZE : 0);
+    apply_delta(prev_mem, delta, pool + cur->offset + cur->len);
+    // Sur une keyframe, l'image complète recale la mémoire
+    if (prev->key)
+        memcpy(prev_mem, pool + prev->offset + sizeof(Rewind_Regs), MEM_SIZE);
+
+    count--;
+    pool_head = prev->offset + prev->len;
+    since_key = 0;
+    for (uint32_t i = count; i > 0 && !entry_at(i - 1)->key; i--)
+        since_key++;
+
+    memcpy(&regs, pool + prev->offset, sizeof(regs)); // Pas forcément aligné dans pool
+    memcpy(snap.regs, regs.regs, CPU_REGS_SIZE);
+    snap.clock = regs.clock;
+    snap.io = regs.io;
+    memcpy(snap.ram, prev_mem, MEM_SIZE);
+    load_snapshot(cpu, &snap);
+    return true;
+}
+
+void get_rewind_stats(Rewind_Stats *stats)
+{
+    stats->frames = count;
+    stats->bytes = 0;
+    for (uint32_t i = 0; i < count; i++)
+        stats->bytes += entry_at(i)->len;
+    stats->capacity = pool_size;
+    stats->delta_avg = nb_deltas ? (double)delta_total / nb_deltas : 0;
+    stats->capture_avg_us = nb_captures ? capture_ticks * 1000000.0 / SDL_GetPerformanceFrequency() / nb_captures : 0;
+}
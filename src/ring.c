@@ -0,0 +1,105 @@
+#include "../includes/ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+head et tail sont des compteurs qui ne font qu'augmenter (ils reviennent à 0
+après 4 Go, la soustraction non signée reste juste). L'indice dans buf est
+compteur & (size - 1). Le producteur publie head après avoir copié les données,
+le consommateur publie tail après les avoir lues : les accès atomiques de SDL
+font office de barrières entre les deux threads.
+*/
+
+int init_ring(Ring *ring, uint32_t min_size)
+{
+    uint32_t size = 1;
+    while (size < min_size)
+        size <<= 1;
+    ring->buf = malloc(size);
+    if (!ring->buf)
+        return -1;
+    ring->size = size;
+    SDL_SetAtomicU32(&ring->head, 0);
+    SDL_SetAtomicU32(&ring->tail, 0);
+    return 0;
+}
+
+void free_ring(Ring *ring)
+{
+    free(ring->buf);
+    ring->buf = NULL;
+    ring->size = 0;
+}
+
+uint32_t ring_used(Ring *ring)
+{
+    return SDL_GetAtomicU32(&ring->head) - SDL_GetAtomicU32(&ring->tail);
+}
+
+uint32_t ring_free(Ring *ring)
+{
+    return ring->size - ring_used(ring);
+}
+
+static void copy_in(Ring *ring, uint32_t pos, const uint8_t *data, uint32_t len)
+{
+    uint32_t idx = pos & (ring->size - 1);
+    uint32_t first = ring->size - idx < len ? ring->size - idx : len;
+    memcpy(ring->buf + idx, data, first);
+    memcpy(ring->buf, data + first, len - first);
+}
+
+static void copy_out(Ring *ring, uint32_t pos, uint8_t *out, uint32_t len)
+{
+    uint32_t idx = pos & (ring->size - 1);
+    uint32_t first = ring->size - idx < len ? ring->size - idx : len;
+    memcpy(out, ring->buf + idx, first);
+    memcpy(out + first, ring->buf, len - first);
+}
+
+// Producteur : écrit len octets d'un coup ou rien du tout
+bool ring_push(Ring *ring, const void *data, uint32_t len)
+{
+    uint32_t head = SDL_GetAtomicU32(&ring->head);
+    if (ring->size - (head - SDL_GetAtomicU32(&ring->tail)) < len)
+        return false;
+    copy_in(ring, head, data, len);
+    SDL_SetAtomicU32(&ring->head, head + len);
+    return true;
+}
+
+// Producteur : écrit autant que possible, renvoie le nombre d'octets écrits
+uint32_t ring_write(Ring *ring, const void *data, uint32_t len)
+{
+    uint32_t head = SDL_GetAtomicU32(&ring->head);
+    uint32_t space = ring->size - (head - SDL_GetAtomicU32(&ring->tail));
+    if (len > space)
+        len = space;
+    copy_in(ring, head, data, len);
+    SDL_SetAtomicU32(&ring->head, head + len);
+    return len;
+}
+
+// Consommateur : lit len octets d'un coup ou rien du tout
+bool ring_pop(Ring *ring, void *out, uint32_t len)
+{
+    uint32_t tail = SDL_GetAtomicU32(&ring->tail);
+    if (SDL_GetAtomicU32(&ring->head) - tail < len)
+        return false;
+    copy_out(ring, tail, out, len);
+    SDL_SetAtomicU32(&ring->tail, tail + len);
+    return true;
+}
+
+// Consommateur : lit jusqu'à len octets, renvoie le nombre d'octets lus
+uint32_t ring_read(Ring *ring, void *out, uint32_t len)
+{
+    uint32_t tail = SDL_GetAtomicU32(&ring->tail);
+    uint32_t avail = SDL_GetAtomicU32(&ring->head) - tail;
+    if (len > avail)
+        len = avail;
+    copy_out(ring, tail, out, len);
+    SDL_SetAtomicU32(&ring->tail, tail + len);
+    return len;
+}
@@ -0,0 +1,50 @@
+#include "../includes/runahead.h"
+#include "../includes/snapshot.h"
+#include "../includes/frame.h"
+
+/*
+Run-ahead : le jeu lit les entrées dans ses interrupts, il faut donc une frame
+ou plus avant qu'une touche se voie à l'écran. Après chaque frame réelle (qui
+n'est pas affichée mais part aux consommateurs), on sauvegarde la machine,
+on émule N frames avec les entrées courantes, on affiche la dernière, puis on
+restaure : la partie continue depuis la frame réelle.
+*/
+
+static int frames = 0;
+
+int init_runahead(int n)
+{
+    if (n < 0 || n > RUNAHEAD_MAX)
+        return -1;
+    frames = n;
+    set_frame_output(frames == 0, true);
+    return 0;
+}
+
+int get_runahead()
+{
+    return frames;
+}
+
+// À appeler à la fin de chaque frame réelle, une fois les entrées figées
+void run_ahead(CPU *cpu)
+{
+    static Snapshot snap;
+
+    // La frame d'avance ne serait pas affichée (rattrapage, turbo) : inutile de la jouer
+    if (!frames || is_present_skipped())
+        return;
+    save_snapshot(cpu, &snap);
+    // Le son de ces frames sera joué pour de vrai plus tard : pas deux fois
+    I8080_Sound_Fn sound = cpu->hooks.sound;
+    cpu->hooks.sound = NULL;
+    for (int i = 1; i <= frames; i++)
+    {
+        set_frame_output(i == frames, false);
+        while (run_emu(cpu) != EMU_END_FRAME)
+            ;
+    }
+    load_snapshot(cpu, &snap);
+    cpu->hooks.sound = sound;
+    set_frame_output(false, true);
+}
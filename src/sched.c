@@ -0,0 +1,64 @@
+#include "../includes/sched.h"
+
+/*
+Échéancier de la machine, en cycles absolus. Le CPU n'a qu'une comparaison à
+faire après chaque instruction (get_cyc() contre next) ; un périphérique
+minuté de plus ne coûte rien tant que son échéance n'est pas atteinte. À cycle
+égal, l'ordre des Sched_Id décide : le rejeu reste déterministe.
+*/
+
+static bool before(const Sched_Event *a, const Sched_Event *b)
+{
+    return a->at < b->at || (a->at == b->at && a->id < b->id);
+}
+
+static void swap(Sched_Event *a, Sched_Event *b)
+{
+    Sched_Event t = *a;
+    *a = *b;
+    *b = t;
+}
+
+void sched_clear(Scheduler *s)
+{
+    s->count = 0;
+    s->next = UINT64_MAX;
+}
+
+int sched_add(Scheduler *s, Sched_Id id, uint64_t at)
+{
+    if (s->count == SCHED_MAX)
+        return -1;
+    uint32_t i = s->count++;
+    s->heap[i] = (Sched_Event){ at, id };
+    while (i > 0 && before(&s->heap[i], &s->heap[(i - 1) / 2]))
+    {
+        swap(&s->heap[i], &s->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    s->next = s->heap[0].at;
+    return 0;
+}
+
+// Retire la plus proche échéance, atteinte ou non
+bool sched_pop(Scheduler *s, Sched_Event *out)
+{
+    if (!s->count)
+        return false;
+    *out = s->heap[0];
+    s->heap[0] = s->heap[--s->count];
+    for (uint32_t i = 0; ; )
+    {
+        uint32_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < s->count && before(&s->heap[l], &s->heap[m]))
+            m = l;
+        if (r < s->count && before(&s->heap[r], &s->heap[m]))
+            m = r;
+        if (m == i)
+            break;
+        swap(&s->heap[i], &s->heap[m]);
+        i = m;
+    }
+    s->next = s->count ? s->heap[0].at : UINT64_MAX;
+    return true;
+}
@@ -0,0 +1,351 @@
+#include "../includes/session.h"
+#include "../includes/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+Session : film d'entrées avec des checkpoints, pour aller directement à une
+frame d'un long enregistrement. Toutes les interval frames, l'état complet
+de la machine (i8080_save_state) et son hash sont écrits dans le flux ; un
+index des checkpoints termine le fichier. Aller à la frame f, c'est charger
+le checkpoint qui la précède puis émuler au plus interval frames.
+
+Une frame est un latch des entrées : l'état d'un checkpoint est pris juste
+après le latch de sa frame. Dans le fichier, le premier latch est la frame
+0 ; session_seek() et ses stats numérotent comme get_frame_number() et
+--frames, à partir de 1 (frame n = bloc n - 1). Le rejeu complet (verify) part du premier
+checkpoint et compare le hash de chaque checkpoint croisé à celui de la
+machine rejouée : une divergence trahit une perte de déterminisme.
+
+Format (petit-boutiste, sauf les états, propres à la machine comme les .state) :
+ "SISS", version, 3 octets réservés, interval (4), taille d'un état (4)
+ blocs 'C' : frame (4), hash (8), taille (4), état
+ blocs 'I' : première frame (4), nombre (4), ports 1 et 2 de chaque frame
+ "SIDX", nombre (4), puis par checkpoint : frame (4), position (8), hash (8)
+ fin : position de l'index (8), nombre de frames (4), "SEND"
+*/
+
+#define HEADER_SIZE 16
+#define TRAILER_SIZE 16
+#define INDEX_ENTRY 20
+
+typedef struct Checkpoint
+{
+    uint32_t frame;
+    uint64_t offset;
+    uint64_t hash;
+} Checkpoint;
+
+static struct
+{
+    FILE *out;
+    uint32_t interval;
+    uint8_t *inputs;     // Frames pas encore écrites, 2 octets chacune
+    uint32_t pending;
+    uint8_t *state;
+    size_t state_size;
+    Checkpoint *index;
+    uint32_t nb_index;
+    uint32_t cap_index;
+    Session_Stats stats;
+} rec;
+
+static struct
+{
+    FILE *in;
+    uint32_t interval;
+    uint32_t frames;
+    uint8_t *state;
+    size_t state_size;
+    Checkpoint *index;
+    uint32_t nb_index;
+    Session_Stats stats;
+} play;
+
+static void write_bytes(const void *p, size_t n)
+{
+    fwrite(p, 1, n, rec.out);
+    rec.stats.bytes += n;
+}
+
+static void flush_inputs()
+{
+    uint8_t head[9] = { 'I' };
+
+    if (!rec.pending)
+        return;
+    put_le32(head + 1, rec.stats.frames - rec.pending);
+    put_le32(head + 5, rec.pending);
+    write_bytes(head, sizeof(head));
+    write_bytes(rec.inputs, rec.pending * 2);
+    rec.pending = 0;
+}
+
+static int write_checkpoint(const I8080_Machine *m, uint32_t frame)
+{
+    uint8_t head[17] = { 'C' };
+    Checkpoint cp = { frame, rec.stats.bytes, i8080_state_hash(m) };
+
+    if (rec.nb_index == rec.cap_index)
+    {
+        uint32_t cap = rec.cap_index ? rec.cap_index * 2 : 64;
+        Checkpoint *grown = realloc(rec.index, cap * sizeof(Checkpoint));
+        if (!grown)
+            return -1;
+        rec.index = grown;
+        rec.cap_index = cap;
+    }
+    rec.index[rec.nb_index++] = cp;
+    i8080_save_state(m, rec.state, rec.state_size);
+    put_le32(head + 1, frame);
+    put_le64(head + 5, cp.hash);
+    put_le32(head + 13, (uint32_t)rec.state_size);
+    write_bytes(head, sizeof(head));
+    write_bytes(rec.state, rec.state_size);
+    rec.stats.checkpoints++;
+    return 0;
+}
+
+int start_session_record(const char *path, int interval)
+{
+    uint8_t header[HEADER_SIZE] = { 'S', 'I', 'S', 'S', SESSION_VERSION };
+
+    if (rec.out || interval < 1)
+        return -1;
+    rec.interval = interval;
+    rec.state_size = i8080_state_size();
+    rec.inputs = malloc(interval * 2);
+    rec.state = malloc(rec.state_size);
+    rec.out = fopen(path, "wb");
+    if (!rec.inputs || !rec.state || !rec.out)
+    {
+        if (!rec.out)
+            perror("Error fopen session:");
+        stop_session_record();
+        return -1;
+    }
+    put_le32(header + 8, interval);
+    put_le32(header + 12, (uint32_t)rec.state_size);
+    memset(&rec.stats, 0, sizeof(rec.stats));
+    rec.pending = 0;
+    rec.nb_index = 0;
+    write_bytes(header, sizeof(header));
+    return 0;
+}
+
+// Après chaque latch : les entrées que le jeu va lire, et un checkpoint toutes les interval frames
+void session_latch(const I8080_Machine *m, uint8_t port1, uint8_t port2)
+{
+    if (!rec.out)
+        return;
+    if (rec.stats.frames % rec.interval == 0)
+    {
+        flush_inputs();
+        write_checkpoint(m, rec.stats.frames);
+    }
+    rec.inputs[rec.pending * 2] = port1;
+    rec.inputs[rec.pending * 2 + 1] = port2;
+    rec.pending++;
+    rec.stats.frames++;
+}
+
+void stop_session_record()
+{
+    uint8_t buf[TRAILER_SIZE];
+
+    if (rec.out)
+    {
+        flush_inputs();
+        uint64_t index_pos = rec.stats.bytes;
+        memcpy(buf, "SIDX", 4);
+        put_le32(buf + 4, rec.nb_index);
+        write_bytes(buf, 8);
+        for (uint32_t i = 0; i < rec.nb_index; i++)
+        {
+            put_le32(buf, rec.index[i].frame);
+            put_le64(buf + 4, rec.index[i].offset);
+            put_le64(buf + 12, rec.index[i].hash);
+            write_bytes(buf, INDEX_ENTRY);
+        }
+        put_le64(buf, index_pos);
+        put_le32(buf + 8, rec.stats.frames);
+        memcpy(buf + 12, "SEND", 4);
+        write_bytes(buf, TRAILER_SIZE);
+        fclose(rec.out);
+        rec.out = NULL;
+    }
+    free(rec.inputs);
+    free(rec.state);
+    free(rec.index);
+    rec.inputs = rec.state = NULL;
+    rec.index = NULL;
+    rec.cap_index = 0;
+}
+
+// Lit l'en-tête, la fin et l'index : le reste du fichier n'est lu qu'au seek
+int open_session(const char *path)
+{
+    uint8_t header[HEADER_SIZE], trailer[TRAILER_SIZE], entry[INDEX_ENTRY];
+
+    close_session();
+    play.in = fopen(path, "rb");
+    if (!play.in)
+    {
+        perror("Error fopen session:");
+        return -1;
+    }
+    if (fread(header, 1, HEADER_SIZE, play.in) != HEADER_SIZE || memcmp(header, "SISS", 4) != 0
+        || header[4] != SESSION_VERSION || get_le32(header + 12) != i8080_state_size()
+        || fseek(play.in, -TRAILER_SIZE, SEEK_END) != 0
+        || fread(trailer, 1, TRAILER_SIZE, play.in) != TRAILER_SIZE || memcmp(trailer + 12, "SEND", 4) != 0)
+    {
+        printf("ERR: %s is not a finished version %d session for this build\n", path, SESSION_VERSION);
+        close_session();
+        return -1;
+    }
+    memset(&play.stats, 0, sizeof(play.stats));
+    play.stats.bytes = ftell(play.in);
+    play.interval = get_le32(header + 8);
+    play.frames = get_le32(trailer + 8);
+    play.state_size = i8080_state_size();
+    fseek(play.in, (long)get_le64(trailer), SEEK_SET);
+    if (fread(header, 1, 8, play.in) != 8 || memcmp(header, "SIDX", 4) != 0)
+    {
+        close_session();
+        return -1;
+    }
+    play.nb_index = get_le32(header + 4);
+    play.index = malloc((play.nb_index ? play.nb_index : 1) * sizeof(Checkpoint));
+    play.state = malloc(play.state_size);
+    if (!play.index || !play.state || !play.nb_index)
+    {
+        close_session();
+        return -1;
+    }
+    for (uint32_t i = 0; i < play.nb_index; i++)
+    {
+        if (fread(entry, 1, INDEX_ENTRY, play.in) != INDEX_ENTRY)
+        {
+            close_session();
+            return -1;
+        }
+        play.index[i] = (Checkpoint){ get_le32(entry), get_le64(entry + 4), get_le64(entry + 12) };
+    }
+    return 0;
+}
+
+uint32_t get_session_frames()
+{
+    return play.frames;
+}
+
+static int load_checkpoint(I8080_Machine *m, const Checkpoint *cp)
+{
+    uint8_t head[17];
+
+    fseek(play.in, (long)cp->offset, SEEK_SET);
+    if (fread(head, 1, sizeof(head), play.in) != sizeof(head) || head[0] != 'C'
+        || fread(play.state, 1, play.state_size, play.in) != play.state_size)
+        return -1;
+    return i8080_load_state(m, play.state, play.state_size);
+}
+
+static void check(I8080_Machine *m, uint32_t frame, uint64_t hash)
+{
+    play.stats.checkpoints++;
+    if (i8080_state_hash(m) == hash)
+        return;
+    if (!play.stats.mismatches)
+        play.stats.first_mismatch = frame + 1;
+    play.stats.mismatches++;
+}
+
+// Machine à la frame donnée (1 à get_session_frames(), juste après son latch).
+// verify : part du premier checkpoint et compare tous ceux qu'elle croise
+int session_seek(I8080_Machine *m, uint32_t frame, bool verify)
+{
+    clock_t t0 = clock();
+    uint8_t head[17], ports[2];
+    uint32_t c = 0;
+    bool pending_check = false;
+    uint32_t check_frame = 0;
+    uint64_t check_hash = 0;
+
+    if (!play.in || frame < 1 || frame > play.frames)
+        return -1;
+    frame--; // Numérotation du fichier
+    while (!verify && c + 1 < play.nb_index && play.index[c + 1].frame <= frame)
+        c++;
+    if (load_checkpoint(m, &play.index[c]) != 0)
+        return -1;
+    uint32_t cur = play.index[c].frame;
+    // Les stats décrivent ce seek seul : une vérification ratée ne pèse pas sur les suivants
+    play.stats.seek_from = cur + 1;
+    play.stats.seek_frames = 0;
+    play.stats.checkpoints = 0;
+    play.stats.mismatches = 0;
+    play.stats.first_mismatch = 0;
+
+    while (cur < frame)
+    {
+        if (fread(head, 1, 1, play.in) != 1)
+            return -1;
+        if (head[0] == 'C')
+        {
+            if (fread(head + 1, 1, 16, play.in) != 16)
+                return -1;
+            fseek(play.in, get_le32(head + 13), SEEK_CUR);
+            // Pris après le latch de sa frame : comparé une fois ses entrées posées
+            pending_check = verify;
+            check_frame = get_le32(head + 1);
+            check_hash = get_le64(head + 5);
+            continue;
+        }
+        if (head[0] != 'I' || fread(head + 1, 1, 8, play.in) != 8)
+            return -1;
+        uint32_t first = get_le32(head + 1);
+        uint32_t count = get_le32(head + 5);
+        for (uint32_t i = 0; i < count && cur < frame; i++)
+        {
+            if (fread(ports, 1, 2, play.in) != 2)
+                return -1;
+            if (first + i <= cur)
+                continue;
+            i8080_run_frame(m);
+            i8080_set_inputs(m, ports[0], ports[1]);
+            cur++;
+            play.stats.seek_frames++;
+            play.stats.frames++;
+            if (pending_check && cur == check_frame)
+            {
+                check(m, check_frame, check_hash);
+                pending_check = false;
+            }
+        }
+    }
+    play.stats.seek_ms = (double)(clock() - t0) * 1000 / CLOCKS_PER_SEC;
+    return play.stats.mismatches ? 1 : 0;
+}
+
+void close_session()
+{
+    if (play.in)
+        fclose(play.in);
+    free(play.index);
+    free(play.state);
+    play.in = NULL;
+    play.index = NULL;
+    play.state = NULL;
+    play.nb_index = 0;
+}
+
+void get_session_stats(Session_Stats *r, Session_Stats *p)
+{
+    if (r)
+        *r = rec.stats;
+    if (p)
+        *p = play.stats;
+}
@@ -0,0 +1,92 @@
+#include "../includes/snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+Sauvegarde d'état. Toute la machine est dans CPU (horloge, registres de la
+borne, mémoire) : sauvegarder, c'est une poignée de memcpy, sans sérialiser
+champ par champ. Le même bloc sert au run-ahead, au rewind et aux fichiers,
+précédé d'un en-tête versionné. Les fichiers sont propres à la machine qui les
+a écrits (ordre des octets, alignement), comme les fichiers de config du jeu.
+*/
+
+void save_snapshot(const CPU *cpu, Snapshot *snap)
+{
+    memcpy(snap->regs, cpu, CPU_REGS_SIZE);
+    snap->clock = cpu->clock;
+    memcpy(snap->ram, cpu->memory + RAM_START, RAM_SIZE);
+    memcpy(snap->vram, cpu->memory + VRAM_START, VRAM_SIZE);
+    snap->io = cpu->io;
+}
+
+void load_snapshot(CPU *cpu, const Snapshot *snap)
+{
+    memcpy(cpu, snap->regs, CPU_REGS_SIZE);
+    cpu->clock = snap->clock;
+    memcpy(cpu->memory + RAM_START, snap->ram, RAM_SIZE);
+    memcpy(cpu->memory + VRAM_START, snap->vram, VRAM_SIZE);
+    cpu->io = snap->io;
+}
+
+uint64_t rom_hash(const CPU *cpu)
+{
+    return cpu->rom_hash;
+}
+
+void save_state(const CPU *cpu, Save_State *state)
+{
+    memcpy(state->header.magic, "SIST", 4);
+    state->header.version = STATE_VERSION;
+    state->header.header_size = sizeof(State_Header);
+    state->header.state_size = sizeof(Snapshot);
+    state->header.reserved = 0;
+    state->header.rom_hash = rom_hash(cpu);
+    save_snapshot(cpu, &state->snap);
+}
+
+int load_state(CPU *cpu, const Save_State *state)
+{
+    const State_Header *h = &state->header;
+
+    if (memcmp(h->magic, "SIST", 4) != 0 || h->version != STATE_VERSION
+        || h->header_size != sizeof(State_Header) || h->state_size != sizeof(Snapshot))
+        return -1;
+    if (h->rom_hash != rom_hash(cpu))
+        return -1;
+    load_snapshot(cpu, &state->snap);
+    return 0;
+}
+
+int save_state_file(const CPU *cpu, const char *path)
+{
+    static Save_State state;
+
+    save_state(cpu, &state);
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        perror("Error fopen state:");
+        return -1;
+    }
+    size_t written = fwrite(&state, sizeof(state), 1, f);
+    fclose(f);
+    return written == 1 ? 0 : -1;
+}
+
+int load_state_file(CPU *cpu, const char *path)
+{
+    static Save_State state;
+
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        perror("Error fopen state:");
+        return -1;
+    }
+    size_t got = fread(&state, sizeof(state), 1, f);
+    fclose(f);
+    if (got != 1)
+        return -1;
+    return load_state(cpu, &state);
+}
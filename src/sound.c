@@ -0,0 +1,442 @@
+#include "../includes/sound.h"
+#include "../includes/cpu8080.h"
+#include "../includes/ring.h"
+#include "../includes/synth.h"
+#include "../includes/wav.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+OUTPUTS (write_io)
+Port 3
+ bit 0 = UFO (répété)
+ bit 1 = Tir
+ bit 2 = Mort du joueur
+ bit 3 = Mort d'un envahisseur
+ bit 4 = Vie supplémentaire
+ bit 5 = AMP enable
+
+Port 5
+ bit 0-3 = Déplacement de la flotte (4 notes)
+ bit 4 = UFO touché
+
+Les changements de bits sont horodatés en cycles CPU pendant la frame, puis
+mixés en fin de frame à leur position exacte dans le flux audio. Le thread
+de l'émulation pousse les échantillons dans une file sans verrou, le callback
+audio de SDL ne fait que la vider : ni verrou ni attente d'un côté ou de l'autre.
+Le même flux peut être capturé dans un fichier WAV (wav.c), avec ou sans sortie.
+
+Les deux horloges (CPU émulé, carte son) dérivent : à chaque fin de frame, le
+remplissage de la file est comparé à la cible et le ratio de ré-échantillonnage
+de SDL est corrigé d'au plus ±0,5 %, trop peu pour s'entendre. En pacing audio,
+c'est en plus la consommation de la carte qui rythme l'émulation (voir pacer.c).
+*/
+
+#define MAX_EVENTS 256
+#define RING_SAMPLES 8192 // ~170 ms à 48 kHz
+#define RATIO_SMOOTHING 0.05 // Part de la nouvelle correction appliquée à chaque frame
+#define MIX_CHUNK 512
+
+typedef struct Sound_Event
+{
+    uint64_t cyc;
+    uint8_t port;
+    uint8_t value;
+} Sound_Event;
+
+typedef struct Voice
+{
+    int16_t *data;
+    uint32_t len;   // En échantillons
+    uint32_t pos;
+    bool active;
+    bool loop;
+} Voice;
+
+static Voice voices[NB_SOUNDS];
+static Sound_Event events[MAX_EVENTS];
+static int nb_events = 0;
+static uint64_t mixed = 0; // Échantillons produits depuis le démarrage
+
+static Sound_Engine engine = SOUND_SYNTH;
+static bool enabled = false;
+static bool muted = false; // Turbo : rien ne part vers la carte, la capture WAV continue
+static Ring ring;
+static SDL_AudioStream *stream = NULL;
+static SDL_AtomicInt underruns;
+static uint32_t overruns = 0;
+static uint32_t nb_captured = 0;
+
+static uint32_t target = 0;
+static double ratio = 1.0;
+static uint32_t fill_min = UINT32_MAX, fill_max = 0;
+static uint64_t fill_total = 0;
+static uint32_t nb_fills = 0;
+static double ratio_min = 1.0, ratio_max = 1.0;
+static double latency_ms = 0;
+
+static const SDL_AudioSpec mix_spec = { SDL_AUDIO_S16, 1, SOUND_RATE };
+
+static const struct { const char *name; Sound_Engine engine; } engine_names[] = {
+    { "synth",   SOUND_SYNTH },
+    { "samples", SOUND_SAMPLES },
+};
+
+int parse_sound_engine(const char *name, Sound_Engine *out)
+{
+    for (size_t i = 0; i < sizeof(engine_names) / sizeof(engine_names[0]); i++)
+    {
+        if (strcmp(name, engine_names[i].name) == 0)
+        {
+            *out = engine_names[i].engine;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Ne tourne que sur le thread audio de SDL
+static void SDLCALL audio_callback(void *user, SDL_AudioStream *s, int additional, int total)
+{
+    int16_t buf[MIX_CHUNK];
+    (void)user;
+    (void)total;
+
+    while (additional > 0)
+    {
+        uint32_t want = additional < (int)sizeof(buf) ? (uint32_t)additional & ~1u : sizeof(buf);
+        if (!want)
+            break;
+        uint32_t got = ring_read(&ring, buf, want);
+        if (got < want)
+        {
+            memset((uint8_t *)buf + got, 0, want - got);
+            SDL_AddAtomicInt(&underruns, 1);
+        }
+        SDL_PutAudioStreamData(s, buf, want);
+        additional -= want;
+    }
+}
+
+static bool load_sample(const char *dir, int id)
+{
+    char path[512];
+    SDL_AudioSpec spec;
+    Uint8 *wav;
+    Uint32 wav_len;
+    Uint8 *data;
+    int len;
+
+    snprintf(path, sizeof(path), "%s/%d.wav", dir, id);
+    if (!SDL_LoadWAV(path, &spec, &wav, &wav_len))
+        return false;
+    if (SDL_ConvertAudioSamples(&spec, wav, wav_len, &mix_spec, &data, &len))
+    {
+        voices[id].data = (int16_t *)data;
+        voices[id].len = len / sizeof(int16_t);
+    }
+    SDL_free(wav);
+    return voices[id].data != NULL;
+}
+
+// samples_dir: dossier des échantillons 0.wav à 9.wav (ceux qui manquent restent muets,
+// sans aucun la synthèse prend le relais)
+// output: ouvre le périphérique audio, sinon rien n'est mixé
+// latency_ms: remplissage visé de la file, la correction de ratio tend vers lui
+int init_sound(Sound_Engine e, const char *samples_dir, bool output, int latency_ms)
+{
+    engine = e;
+    if (latency_ms < 5)
+        latency_ms = 5;
+    target = (uint32_t)latency_ms * SOUND_RATE / 1000;
+    if (target > RING_SAMPLES / 2)
+        target = RING_SAMPLES / 2;
+
+    if (engine == SOUND_SYNTH)
+        init_synth(SOUND_RATE);
+    else
+    {
+        int nb_loaded = 0;
+        for (int id = 0; id < NB_SOUNDS; id++)
+            nb_loaded += load_sample(samples_dir, id);
+        voices[SND_UFO].loop = true;
+        if (nb_loaded == 0)
+        {
+            printf("ERR: no samples (0.wav to %d.wav) found in %s, using the synth engine\n", NB_SOUNDS - 1, samples_dir);
+            engine = SOUND_SYNTH;
+            init_synth(SOUND_RATE);
+        }
+        else if (nb_loaded < NB_SOUNDS)
+            printf("ERR: only %d/%d samples found in %s, the others stay silent\n", nb_loaded, NB_SOUNDS, samples_dir);
+    }
+
+    if (!output)
+        return 0;
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO))
+    {
+        SDL_Log("SDL_Init audio: %s", SDL_GetError());
+        return 1;
+    }
+    if (init_ring(&ring, RING_SAMPLES * sizeof(int16_t)) != 0)
+        return 1;
+    stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &mix_spec, audio_callback, NULL);
+    if (!stream)
+    {
+        SDL_Log("OpenAudioDeviceStream: %s", SDL_GetError());
+        free_ring(&ring);
+        return 1;
+    }
+    enabled = true;
+    SDL_ResumeAudioStreamDevice(stream);
+    return 0;
+}
+
+void quit_sound()
+{
+    if (stream)
+        SDL_DestroyAudioStream(stream);
+    stream = NULL;
+    if (enabled)
+    {
+        free_ring(&ring);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+    enabled = false;
+    for (int id = 0; id < NB_SOUNDS; id++)
+    {
+        SDL_free(voices[id].data);
+        voices[id].data = NULL;
+    }
+}
+
+// Hook son de la machine : appelé quand un octet change sur le port 3 ou 5
+void sound_write(uint8_t port, uint8_t value, uint64_t cyc)
+{
+    nb_captured++;
+    if (nb_events < MAX_EVENTS)
+        events[nb_events++] = (Sound_Event){ cyc, port, value };
+}
+
+static void start_voice(Sound_Id id, bool on)
+{
+    if (voices[id].loop)
+    {
+        voices[id].active = on;
+        if (!on)
+            voices[id].pos = 0;
+        return;
+    }
+    // Les autres sons partent sur le front montant et vont jusqu'au bout
+    if (on)
+    {
+        voices[id].active = true;
+        voices[id].pos = 0;
+    }
+}
+
+static uint8_t mix_port3 = 0;
+static uint8_t mix_port5 = 0;
+static const Sound_Id port3_ids[5] = { SND_UFO, SND_SHOT, SND_PLAYER_DIE, SND_INVADER_DIE, SND_EXTRA_LIFE };
+static const Sound_Id port5_ids[5] = { SND_FLEET_1, SND_FLEET_2, SND_FLEET_3, SND_FLEET_4, SND_UFO_HIT };
+
+static void apply_event(const Sound_Event *ev)
+{
+    uint8_t *latch = ev->port == 3 ? &mix_port3 : &mix_port5;
+    const Sound_Id *ids = ev->port == 3 ? port3_ids : port5_ids;
+    uint8_t changed = *latch ^ ev->value;
+
+    for (int bit = 0; bit < 5; bit++)
+    {
+        if (!(changed & (1 << bit)))
+            continue;
+        if (engine == SOUND_SYNTH)
+            synth_gate(ids[bit], (ev->value >> bit) & 1);
+        else
+            start_voice(ids[bit], (ev->value >> bit) & 1);
+    }
+    *latch = ev->value;
+}
+
+static void render(int16_t *out, uint32_t n)
+{
+    bool amp = (mix_port3 >> 5) & 1;
+
+    // Les circuits tournent même ampli coupé, comme sur la carte
+    if (engine == SOUND_SYNTH)
+    {
+        synth_render(out, n);
+        if (!amp)
+            memset(out, 0, n * sizeof(int16_t));
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++)
+    {
+        int32_t sum = 0;
+        for (int id = 0; id < NB_SOUNDS; id++)
+        {
+            Voice *v = &voices[id];
+            if (!v->active || !v->data)
+                continue;
+            sum += v->data[v->pos++];
+            if (v->pos >= v->len)
+            {
+                v->pos = 0;
+                v->active = v->loop;
+            }
+        }
+        if (!amp)
+            sum = 0;
+        out[i] = sum > 32767 ? 32767 : sum < -32768 ? -32768 : (int16_t)sum;
+    }
+}
+
+// Produit les échantillons jusqu'au cycle cyc et les pousse dans la file
+static void mix_until(uint64_t target)
+{
+    int16_t buf[MIX_CHUNK];
+
+    while (mixed < target)
+    {
+        uint32_t n = target - mixed < MIX_CHUNK ? (uint32_t)(target - mixed) : MIX_CHUNK;
+        render(buf, n);
+        if (enabled && !muted)
+        {
+            uint32_t pushed = ring_write(&ring, buf, n * sizeof(int16_t));
+            overruns += n - pushed / sizeof(int16_t);
+        }
+        wav_capture_push(buf, n);
+        mixed += n;
+    }
+}
+
+static inline uint64_t cyc_to_sample(uint64_t cyc)
+{
+    return cyc * SOUND_RATE / CPU_CLOCK;
+}
+
+bool sound_is_output()
+{
+    return enabled;
+}
+
+uint32_t get_sound_queued()
+{
+    return enabled ? ring_used(&ring) / sizeof(int16_t) : 0;
+}
+
+uint32_t get_sound_target()
+{
+    return target;
+}
+
+// Contrôle dynamique du débit : file trop pleine, la carte lit un peu plus vite
+static void update_ratio()
+{
+    uint32_t fill = get_sound_queued();
+    double error = ((double)fill - target) / target;
+
+    if (error > 1)
+        error = 1;
+    if (error < -1)
+        error = -1;
+    double wanted = 1.0 + SOUND_MAX_DRIFT * error;
+    double next = ratio + (wanted - ratio) * RATIO_SMOOTHING;
+    if (SDL_fabs(next - ratio) > 1e-5 && SDL_SetAudioStreamFrequencyRatio(stream, (float)next))
+        ratio = next;
+
+    if (fill < fill_min)
+        fill_min = fill;
+    if (fill > fill_max)
+        fill_max = fill;
+    fill_total += fill;
+    nb_fills++;
+    if (ratio < ratio_min)
+        ratio_min = ratio;
+    if (ratio > ratio_max)
+        ratio_max = ratio;
+    int in_sdl = SDL_GetAudioStreamQueued(stream);
+    latency_ms = (fill + (in_sdl > 0 ? in_sdl / sizeof(int16_t) : 0)) * 1000.0 / SOUND_RATE;
+}
+
+// Fin de frame : mixe la frame écoulée en appliquant chaque événement à son échantillon
+void sound_end_frame(uint64_t cyc)
+{
+    if (!enabled && !wav_capture_active())
+    {
+        nb_events = 0;
+        return;
+    }
+    for (int i = 0; i < nb_events; i++)
+    {
+        mix_until(cyc_to_sample(events[i].cyc));
+        apply_event(&events[i]);
+    }
+    nb_events = 0;
+    mix_until(cyc_to_sample(cyc));
+    if (enabled && !muted)
+        update_ratio();
+}
+
+// Le son joué en accéléré n'a aucun sens, et déborderait la file
+void set_sound_muted(bool mute)
+{
+    muted = mute;
+}
+
+// Les sons tenus tant que leur bit est à 1 (la soucoupe) suivent le bit restauré ;
+// les autres partent sur un front et s'éteignent seuls
+static void resync_port(uint8_t *latch, const Sound_Id *ids, uint8_t value)
+{
+    for (int bit = 0; bit < 5; bit++)
+    {
+        bool on = (value >> bit) & 1;
+        if (engine == SOUND_SYNTH && synth_held(ids[bit]) && on != ((*latch >> bit) & 1))
+            synth_gate(ids[bit], on);
+        else if (engine == SOUND_SAMPLES && voices[ids[bit]].loop)
+            start_voice(ids[bit], on);
+    }
+    *latch = value;
+}
+
+// La machine a sauté ailleurs dans le temps (rewind, chargement d'état, rollback) :
+// le mixage repart de là, sans attendre de rattraper l'ancienne position, et ses
+// ports reprennent les octets restaurés (ports[0] = port 3, ports[1] = port 5).
+// Sinon le jeu, qui n'écrit que les changements, ne couperait jamais une soucoupe
+void sound_seek(uint64_t cyc, const uint8_t ports[2])
+{
+    nb_events = 0;
+    mixed = cyc_to_sample(cyc);
+    resync_port(&mix_port3, port3_ids, ports[0]);
+    resync_port(&mix_port5, port5_ids, ports[1]);
+}
+
+// Les échantillons sont capturés à partir de la position courante du mixage
+int start_sound_capture(const char *path, uint64_t cyc)
+{
+    // Sans sortie audio, rien n'a été mixé jusqu'ici : on repart de maintenant
+    if (!enabled)
+        mixed = cyc_to_sample(cyc);
+    return start_wav_capture(path, mixed);
+}
+
+void stop_sound_capture()
+{
+    stop_wav_capture();
+}
+
+void get_sound_stats(Sound_Stats *stats)
+{
+    stats->events = nb_captured;
+    stats->underruns = SDL_GetAtomicInt(&underruns);
+    stats->overruns = overruns;
+    stats->queued = get_sound_queued();
+    stats->target = target;
+    stats->fill_min = nb_fills ? fill_min : 0;
+    stats->fill_max = fill_max;
+    stats->fill_avg = nb_fills ? (double)fill_total / nb_fills : 0;
+    stats->latency_ms = latency_ms;
+    stats->ratio = ratio;
+    stats->ratio_min = ratio_min;
+    stats->ratio_max = ratio_max;
+}
@@ -0,0 +1,578 @@
+#include "../includes/stream.h"
+#include "../includes/i8080.h"
+#include "../includes/memory.h"
+#include "../includes/unixsock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Diffusion locale des frames vers des viewers d'autres processus. Les frames
+passent par un anneau en mémoire partagée (shm_open), sans copie par le
+noyau ; une socket Unix sert de canal de contrôle : un viewer s'y présente
+(HELLO), reçoit le nom de la mémoire partagée, puis envoie ses entrées
+(INPUT <port1> <port2>, en hexa) jusqu'à BYE ou la fermeture.
+
+Chaque case de l'anneau est protégée par un compteur de séquence : impair
+pendant l'écriture de la frame n (2n + 1), 2n + 2 une fois finie. Le viewer
+relit le compteur après sa copie ; s'il a bougé, la frame a été écrasée et
+il attend la prochaine image complète. L'émulateur n'attend jamais personne.
+
+En mode delta, une case contient les plages d'octets modifiés depuis la
+frame précédente (position et longueur sur 2 octets, puis les octets), et
+une image complète revient toutes les STREAM_KEYFRAME frames, dès qu'un
+viewer arrive, ou quand le delta ne serait pas plus petit. Une frame
+identique à la précédente n'est pas publiée : le viewer garde la dernière
+et les cases de l'anneau restent aux frames qui changent l'image.
+*/
+
+#ifdef _WIN32
+
+int parse_stream_format(const char *name, Stream_Format *out)
+{
+    (void)name;
+    (void)out;
+    return -1;
+}
+
+int start_stream_server(const char *path, Stream_Format format)
+{
+    (void)path;
+    (void)format;
+    printf("ERR: frame streaming needs Unix sockets and shared memory\n");
+    return -1;
+}
+
+void stream_frame(const uint8_t *vram, uint32_t number, uint64_t cyc, uint64_t hash, bool changed)
+{
+    (void)vram;
+    (void)number;
+    (void)cyc;
+    (void)hash;
+    (void)changed;
+}
+
+bool stream_poll(uint8_t ports[2])
+{
+    (void)ports;
+    return false;
+}
+
+void stop_stream_server()
+{
+}
+
+int stream_attach(const char *path)
+{
+    (void)path;
+    printf("ERR: frame streaming needs Unix sockets and shared memory\n");
+    return -1;
+}
+
+int stream_next_frame(uint8_t *vram, Stream_Info *info)
+{
+    (void)vram;
+    (void)info;
+    return -1;
+}
+
+int stream_send_inputs(uint8_t port1, uint8_t port2)
+{
+    (void)port1;
+    (void)port2;
+    return -1;
+}
+
+void stream_detach()
+{
+}
+
+void get_stream_stats(Stream_Stats *server, Stream_Stats *viewer)
+{
+    if (server)
+        memset(server, 0, sizeof(*server));
+    if (viewer)
+        memset(viewer, 0, sizeof(*viewer));
+}
+
+#else
+
+# include <stdatomic.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <poll.h>
+# include <signal.h>
+# include <unistd.h>
+
+#define SLOT_DATA I8080_VRAM_SIZE
+#define MIN_GAP 4 // Octets identiques à partir desquels une plage est coupée
+
+typedef struct Stream_Slot
+{
+    _Atomic uint64_t seq;
+    uint32_t number;
+    uint32_t kind;     // STREAM_RAW ou STREAM_DELTA
+    uint32_t len;
+    uint32_t reserved;
+    uint64_t cyc;
+    uint64_t hash;
+    uint8_t data[SLOT_DATA];
+} Stream_Slot;
+
+typedef struct Stream_Shm
+{
+    char magic[4];     // "SISH"
+    uint32_t version;
+    uint32_t slots;
+    uint32_t slot_size;
+    _Atomic uint64_t head; // Frames publiées depuis le début
+    Stream_Slot slot[STREAM_SLOTS];
+} Stream_Shm;
+
+typedef struct Viewer
+{
+    int fd;
+    char line[128];
+    int len;
+    uint8_t ports[2];
+} Viewer;
+
+static struct
+{
+    int sock;
+    char path[108];
+    char shm_name[64];
+    Stream_Shm *shm;
+    Stream_Format format;
+    uint8_t prev[SLOT_DATA];
+    bool force_key;
+    uint32_t last_key;  // Numéro de la dernière image complète
+    Viewer viewers[STREAM_MAX_VIEWERS];
+    int nb_viewers;
+    Stream_Stats stats;
+} server = { .sock = -1 };
+
+static struct
+{
+    int fd;
+    const Stream_Shm *shm;
+    uint64_t next;
+    bool have_key;
+    uint8_t vram[SLOT_DATA];
+    uint8_t data[SLOT_DATA];
+    Stream_Stats stats;
+} viewer = { .fd = -1 };
+
+int parse_stream_format(const char *name, Stream_Format *out)
+{
+    if (strcmp(name, "raw") == 0)
+        *out = STREAM_RAW;
+    else if (strcmp(name, "delta") == 0)
+        *out = STREAM_DELTA;
+    else
+        return -1;
+    return 0;
+}
+
+static void send_line(int fd, const char *s)
+{
+    send(fd, s, strlen(s), MSG_DONTWAIT);
+}
+
+int start_stream_server(const char *path, Stream_Format format)
+{
+    struct sockaddr_un addr;
+
+    if (server.shm || unix_address(path, &addr) != 0)
+        return -1;
+    snprintf(server.shm_name, sizeof(server.shm_name), "/siemu-stream-%d", (int)getpid());
+    int fd = shm_open(server.shm_name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0 || ftruncate(fd, sizeof(Stream_Shm)) != 0)
+    {
+        perror("Error shm_open stream:");
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    server.shm = mmap(NULL, sizeof(Stream_Shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (server.shm == MAP_FAILED)
+    {
+        server.shm = NULL;
+        shm_unlink(server.shm_name);
+        return -1;
+    }
+    memcpy(server.shm->magic, "SISH", 4);
+    server.shm->version = STREAM_VERSION;
+    server.shm->slots = STREAM_SLOTS;
+    server.shm->slot_size = sizeof(Stream_Slot);
+    atomic_store(&server.shm->head, 0);
+
+    server.sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (server.sock < 0 || bind(server.sock, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(server.sock, STREAM_MAX_VIEWERS) != 0)
+    {
+        perror("Error bind stream:");
+        stop_stream_server();
+        return -1;
+    }
+    fcntl(server.sock, F_SETFL, fcntl(server.sock, F_GETFL, 0) | O_NONBLOCK);
+    // Un viewer parti sans prévenir ne doit pas tuer l'émulateur
+    signal(SIGPIPE, SIG_IGN);
+    snprintf(server.path, sizeof(server.path), "%s", path);
+    server.format = format;
+    server.force_key = true;
+    memset(&server.stats, 0, sizeof(server.stats));
+    return 0;
+}
+
+// Plages modifiées entre cur et prev ; SLOT_DATA si ça ne tient pas
+static uint32_t encode_delta(const uint8_t *cur, const uint8_t *prev, uint8_t *out)
+{
+    uint32_t o = 0, i = 0;
+
+    while (i < SLOT_DATA)
+    {
+        if (cur[i] == prev[i])
+        {
+            i++;
+            continue;
+        }
+        uint32_t start = i, end = i;
+        while (i < SLOT_DATA && i - end <= MIN_GAP)
+        {
+            if (cur[i] != prev[i])
+                end = i + 1;
+            i++;
+        }
+        uint32_t len = end - start;
+        if (o + 4 + len >= SLOT_DATA)
+            return SLOT_DATA;
+        out[o++] = start;
+        out[o++] = start >> 8;
+        out[o++] = len;
+        out[o++] = len >> 8;
+        memcpy(out + o, cur + start, len);
+        o += len;
+        i = end;
+    }
+    return o;
+}
+
+static void apply_delta(uint8_t *vram, const uint8_t *p, uint32_t len)
+{
+    const uint8_t *end = p + len;
+
+    while (p + 4 <= end)
+    {
+        uint32_t pos = p[0] | (p[1] << 8);
+        uint32_t n = p[2] | (p[3] << 8);
+        p += 4;
+        if (pos + n > SLOT_DATA || p + n > end)
+            return;
+        memcpy(vram + pos, p, n);
+        p += n;
+    }
+}
+
+// Consommateur de frames : ne bloque jamais, un viewer trop lent perd des frames.
+// changed : l'image diffère de la frame précédente, donc de la dernière publiée
+void stream_frame(const uint8_t *vram, uint32_t number, uint64_t cyc, uint64_t hash, bool changed)
+{
+    if (!server.shm)
+        return;
+    // Un viewer qui vient d'arriver attend une image complète, même inchangée
+    if (!changed && !server.force_key)
+    {
+        server.stats.unchanged++;
+        return;
+    }
+    uint64_t n = atomic_load_explicit(&server.shm->head, memory_order_relaxed);
+    Stream_Slot *slot = &server.shm->slot[n % STREAM_SLOTS];
+
+    atomic_store_explicit(&slot->seq, 2 * n + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    uint32_t len = SLOT_DATA;
+    // Cadence comptée en frames de l'émulateur, publiées ou non
+    bool key = server.format == STREAM_RAW || server.force_key || number - server.last_key >= STREAM_KEYFRAME;
+    if (!key)
+        len = encode_delta(vram, server.prev, slot->data);
+    if (len >= SLOT_DATA)
+    {
+        memcpy(slot->data, vram, SLOT_DATA);
+        len = SLOT_DATA;
+        key = true;
+    }
+    slot->number = number;
+    slot->kind = key ? STREAM_RAW : STREAM_DELTA;
+    slot->len = len;
+    slot->cyc = cyc;
+    slot->hash = hash;
+    atomic_store_explicit(&slot->seq, 2 * n + 2, memory_order_release);
+    atomic_store_explicit(&server.shm->head, n + 1, memory_order_release);
+
+    memcpy(server.prev, vram, SLOT_DATA);
+    if (key)
+        server.last_key = number;
+    server.force_key = false;
+    server.stats.frames++;
+    server.stats.keyframes += key;
+    server.stats.bytes += len;
+}
+
+static void drop_viewer(int i)
+{
+    close(server.viewers[i].fd);
+    server.viewers[i] = server.viewers[--server.nb_viewers];
+}
+
+static void viewer_line(Viewer *v, const char *line)
+{
+    char reply[128];
+    unsigned p1, p2;
+
+    if (strcmp(line, "HELLO") == 0)
+    {
+        snprintf(reply, sizeof(reply), "SHM %s %d %d\n", server.shm_name, STREAM_SLOTS, STREAM_VERSION);
+        send_line(v->fd, reply);
+        server.force_key = true;
+    }
+    else if (sscanf(line, "INPUT %x %x", &p1, &p2) == 2)
+    {
+        v->ports[0] = p1;
+        v->ports[1] = p2;
+        server.stats.inputs++;
+    }
+}
+
+// Une fois par frame : nouveaux viewers, lignes reçues. ports reçoit l'union des
+// entrées des viewers ; renvoie true si au moins un est connecté
+bool stream_poll(uint8_t ports[2])
+{
+    char buf[256];
+
+    ports[0] = ports[1] = 0;
+    if (server.sock < 0)
+        return false;
+    int fd;
+    while ((fd = accept(server.sock, NULL, NULL)) >= 0)
+    {
+        if (server.nb_viewers == STREAM_MAX_VIEWERS)
+        {
+            close(fd);
+            continue;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        server.viewers[server.nb_viewers++] = (Viewer){ .fd = fd };
+        server.stats.viewers++;
+    }
+    for (int i = 0; i < server.nb_viewers; i++)
+    {
+        Viewer *v = &server.viewers[i];
+        ssize_t got;
+        bool closed = false;
+        while ((got = recv(v->fd, buf, sizeof(buf), 0)) > 0)
+        {
+            for (ssize_t k = 0; k < got; k++)
+            {
+                if (buf[k] != '\n' && v->len < (int)sizeof(v->line) - 1)
+                {
+                    v->line[v->len++] = buf[k];
+                    continue;
+                }
+                v->line[v->len] = '\0';
+                v->len = 0;
+                if (strcmp(v->line, "BYE") == 0)
+                    closed = true;
+                else
+                    viewer_line(v, v->line);
+            }
+        }
+        if (got == 0 || closed)
+        {
+            drop_viewer(i--);
+            continue;
+        }
+        ports[0] |= v->ports[0];
+        ports[1] |= v->ports[1];
+    }
+    return server.nb_viewers > 0;
+}
+
+void stop_stream_server()
+{
+    while (server.nb_viewers)
+        drop_viewer(0);
+    if (server.sock >= 0)
+    {
+        close(server.sock);
+        unlink(server.path);
+        server.sock = -1;
+    }
+    if (server.shm)
+    {
+        munmap(server.shm, sizeof(Stream_Shm));
+        shm_unlink(server.shm_name);
+        server.shm = NULL;
+    }
+}
+
+int stream_attach(const char *path)
+{
+    struct sockaddr_un addr;
+    char line[128], name[64];
+    int slots, version;
+
+    stream_detach();
+    viewer.fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (viewer.fd < 0 || unix_address(path, &addr) != 0
+        || connect(viewer.fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        stream_detach();
+        return -1;
+    }
+    send_line(viewer.fd, "HELLO\n");
+    if (read_line(viewer.fd, line, sizeof(line)) < 0
+        || sscanf(line, "SHM %63s %d %d", name, &slots, &version) != 3
+        || slots != STREAM_SLOTS || version != STREAM_VERSION)
+    {
+        stream_detach();
+        return -1;
+    }
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        stream_detach();
+        return -1;
+    }
+    void *p = mmap(NULL, sizeof(Stream_Shm), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        stream_detach();
+        return -1;
+    }
+    viewer.shm = p;
+    if (memcmp(viewer.shm->magic, "SISH", 4) != 0 || viewer.shm->slot_size != sizeof(Stream_Slot))
+    {
+        stream_detach();
+        return -1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    // On part de la dernière frame publiée : le HELLO a demandé une image complète
+    viewer.next = atomic_load_explicit(&viewer.shm->head, memory_order_acquire);
+    viewer.have_key = false;
+    memset(&viewer.stats, 0, sizeof(viewer.stats));
+    return 0;
+}
+
+// Lit la frame n. -1 si elle a été écrasée (ou l'est pendant la copie)
+static int read_slot(uint64_t n, Stream_Slot *out)
+{
+    const Stream_Slot *slot = &viewer.shm->slot[n % STREAM_SLOTS];
+    uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+    if (seq != 2 * n + 2)
+        return -1;
+    out->number = slot->number;
+    out->kind = slot->kind;
+    out->len = slot->len <= SLOT_DATA ? slot->len : SLOT_DATA;
+    out->cyc = slot->cyc;
+    out->hash = slot->hash;
+    memcpy(viewer.data, slot->data, out->len);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq)
+        return -1;
+    return 0;
+}
+
+// Rattrape l'anneau. 1 : vram contient une nouvelle frame, 0 : rien de neuf,
+// -1 : l'émulateur est parti
+int stream_next_frame(uint8_t *vram, Stream_Info *info)
+{
+    struct pollfd pfd = { viewer.fd, POLLIN, 0 };
+    Stream_Slot slot;
+    bool got = false;
+    char c;
+
+    if (viewer.fd < 0)
+        return -1;
+    if (poll(&pfd, 1, 0) > 0 && recv(viewer.fd, &c, 1, MSG_PEEK) <= 0)
+        return -1;
+    uint64_t head = atomic_load_explicit(&viewer.shm->head, memory_order_acquire);
+    // Trop en retard : les plus anciennes sont déjà écrasées
+    if (head > viewer.next + STREAM_SLOTS - 1)
+    {
+        viewer.stats.lost += head - (STREAM_SLOTS - 1) - viewer.next;
+        viewer.next = head - (STREAM_SLOTS - 1);
+        viewer.have_key = false;
+    }
+    for (; viewer.next < head; viewer.next++)
+    {
+        if (read_slot(viewer.next, &slot) != 0)
+        {
+            viewer.stats.lost++;
+            viewer.have_key = false;
+            continue;
+        }
+        viewer.stats.bytes += slot.len;
+        if (slot.kind == STREAM_RAW)
+        {
+            memcpy(viewer.vram, viewer.data, SLOT_DATA);
+            viewer.have_key = true;
+            viewer.stats.keyframes++;
+        }
+        else if (viewer.have_key)
+            apply_delta(viewer.vram, viewer.data, slot.len);
+        else
+            continue; // Delta sans base : on attend la prochaine image complète
+        viewer.stats.frames++;
+        if (hash_vram(viewer.vram) != slot.hash)
+            viewer.stats.bad_hash++;
+        info->number = slot.number;
+        info->cyc = slot.cyc;
+        info->hash = slot.hash;
+        got = true;
+    }
+    if (got)
+        memcpy(vram, viewer.vram, SLOT_DATA);
+    return got;
+}
+
+int stream_send_inputs(uint8_t port1, uint8_t port2)
+{
+    char line[32];
+
+    if (viewer.fd < 0)
+        return -1;
+    snprintf(line, sizeof(line), "INPUT %02x %02x\n", port1, port2);
+    send_line(viewer.fd, line);
+    return 0;
+}
+
+void stream_detach()
+{
+    if (viewer.fd >= 0)
+    {
+        send_line(viewer.fd, "BYE\n");
+        close(viewer.fd);
+        viewer.fd = -1;
+    }
+    if (viewer.shm)
+    {
+        munmap((void *)viewer.shm, sizeof(Stream_Shm));
+        viewer.shm = NULL;
+    }
+}
+
+void get_stream_stats(Stream_Stats *s, Stream_Stats *v)
+{
+    if (s)
+        *s = server.stats;
+    if (v)
+        *v = viewer.stats;
+}
+
+#endif
@@ -0,0 +1,256 @@
+#include "../includes/synth.h"
+
+#include <string.h>
+#include <../includes/SDL3/SDL.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+Synthèse des circuits discrets de la carte, à la place des échantillons.
+Chaque son est une voix : oscillateur carré (VCO) éventuellement modulé par
+un LFO triangle (le "warble" de la soucoupe) et glissant en fréquence, bruit
+blanc (explosions), passe-bas RC à un pôle, enveloppe exponentielle.
+
+Les voix sont rangées en colonnes (une valeur par voix dans chaque tableau) :
+en SSE2, 4 voix sont calculées d'un coup, échantillon par échantillon, et le
+mixage final additionne les 4 voies de 4 échantillons par une transposition.
+*/
+
+#define LANES 12 // NB_SOUNDS arrondi au multiple de 4
+#define BLOCK 256
+#define MASTER 0.5f
+#define SILENCE 1e-4f // En dessous, l'enveloppe tombe à 0 et le glissement s'arrête (évite les flottants dénormalisés)
+#define UFO_RELEASE 0.02f
+
+typedef struct Voice_Params
+{
+    float freq;      // Hz, 0 = pas d'oscillateur
+    float sweep;     // Octaves par seconde (négatif : descend)
+    float lfo_hz;
+    float lfo_depth; // Excursion relative de la fréquence
+    float noise;     // 0 = carré pur, 1 = bruit pur
+    float cutoff;    // Hz, passe-bas
+    float level;
+    float decay;     // Secondes pour perdre 1/e, 0 = tenu tant que le bit est à 1
+} Voice_Params;
+
+static const Voice_Params params[NB_SOUNDS] = {
+    [SND_UFO]         = { 480.0f,  0.0f, 6.5f, 0.30f, 0.0f, 1800.0f, 0.22f, 0.0f },
+    [SND_SHOT]        = {   0.0f,  0.0f, 0.0f, 0.00f, 1.0f, 3500.0f, 0.35f, 0.12f },
+    [SND_PLAYER_DIE]  = {   0.0f,  0.0f, 0.0f, 0.00f, 1.0f,  500.0f, 0.70f, 0.60f },
+    [SND_INVADER_DIE] = { 520.0f, -3.0f, 0.0f, 0.00f, 0.4f, 2500.0f, 0.35f, 0.15f },
+    [SND_FLEET_1]     = {  98.7f,  0.0f, 0.0f, 0.00f, 0.0f,  400.0f, 0.55f, 0.08f },
+    [SND_FLEET_2]     = {  87.8f,  0.0f, 0.0f, 0.00f, 0.0f,  400.0f, 0.55f, 0.08f },
+    [SND_FLEET_3]     = {  78.1f,  0.0f, 0.0f, 0.00f, 0.0f,  400.0f, 0.55f, 0.08f },
+    [SND_FLEET_4]     = {  73.3f,  0.0f, 0.0f, 0.00f, 0.0f,  400.0f, 0.55f, 0.08f },
+    [SND_UFO_HIT]     = { 1000.0f, -1.0f, 12.0f, 0.20f, 0.0f, 3000.0f, 0.30f, 0.70f },
+    [SND_EXTRA_LIFE]  = { 1250.0f,  0.0f, 4.0f, 0.05f, 0.0f, 3000.0f, 0.25f, 0.90f },
+};
+
+// Une valeur par voix ; les voies LANES > NB_SOUNDS restent muettes
+static struct
+{
+    float phase[LANES];
+    float inc[LANES];   // Cycles par échantillon
+    float sweep[LANES]; // Multiplie inc à chaque échantillon
+    float lfo_phase[LANES];
+    float lfo_inc[LANES];
+    float lfo_depth[LANES];
+    float noise[LANES];
+    float lp_k[LANES];
+    float lp[LANES];
+    float amp[LANES];
+    float decay[LANES]; // Multiplie amp à chaque échantillon
+    uint32_t lfsr[LANES];
+} v;
+
+static int rate = 48000;
+static float release;
+
+static float per_sample_decay(float seconds)
+{
+    return seconds > 0 ? (float)SDL_exp(-1.0 / (seconds * rate)) : 1.0f;
+}
+
+void init_synth(int r)
+{
+    rate = r;
+    memset(&v, 0, sizeof(v));
+    release = per_sample_decay(UFO_RELEASE);
+    for (int i = 0; i < LANES; i++)
+    {
+        v.sweep[i] = 1.0f;
+        v.decay[i] = 1.0f;
+        v.lfsr[i] = 0x9E3779B9u * (i + 1); // Xorshift : jamais 0
+    }
+    for (int i = 0; i < NB_SOUNDS; i++)
+    {
+        const Voice_Params *p = &params[i];
+        v.inc[i] = p->freq / rate;
+        v.lfo_inc[i] = p->lfo_hz / rate;
+        v.lfo_depth[i] = p->lfo_depth;
+        v.noise[i] = p->noise;
+        v.lp_k[i] = (float)(1.0 - SDL_exp(-2.0 * SDL_PI_D * p->cutoff / rate));
+    }
+}
+
+// Front montant : la voix repart du début. Front descendant : seule la soucoupe,
+// tenue tant que son bit est à 1, s'éteint (les autres vont au bout de leur enveloppe)
+// Son tenu tant que son bit reste à 1 (sans décroissance propre)
+bool synth_held(Sound_Id id)
+{
+    return params[id].decay == 0;
+}
+
+void synth_gate(Sound_Id id, bool on)
+{
+    const Voice_Params *p = &params[id];
+
+    if (!on)
+    {
+        if (p->decay == 0)
+            v.decay[id] = release;
+        return;
+    }
+    v.amp[id] = p->level;
+    v.decay[id] = per_sample_decay(p->decay);
+    v.inc[id] = p->freq / rate;
+    v.sweep[id] = (float)SDL_pow(2.0, p->sweep / rate);
+    v.phase[id] = 0;
+    v.lfo_phase[id] = 0;
+}
+
+#ifdef __SSE2__
+// 4 voix à partir de la voie g, n échantillons ; acc reçoit 4 flottants par échantillon
+static void render_group(int g, __m128 *acc, uint32_t n, bool first)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 to_float = _mm_set1_ps(1.0f / 2147483648.0f);
+    const __m128 silence = _mm_set1_ps(SILENCE);
+    __m128 phase = _mm_loadu_ps(v.phase + g);
+    __m128 inc = _mm_loadu_ps(v.inc + g);
+    __m128 sweep = _mm_loadu_ps(v.sweep + g);
+    __m128 lfo_phase = _mm_loadu_ps(v.lfo_phase + g);
+    __m128 lfo_inc = _mm_loadu_ps(v.lfo_inc + g);
+    __m128 lfo_depth = _mm_loadu_ps(v.lfo_depth + g);
+    __m128 noise_mix = _mm_loadu_ps(v.noise + g);
+    __m128 lp_k = _mm_loadu_ps(v.lp_k + g);
+    __m128 lp = _mm_loadu_ps(v.lp + g);
+    __m128 amp = _mm_loadu_ps(v.amp + g);
+    __m128 decay = _mm_loadu_ps(v.decay + g);
+    __m128i lfsr = _mm_loadu_si128((const __m128i *)(v.lfsr + g));
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        __m128 live = _mm_cmpgt_ps(amp, silence);
+        // LFO triangle entre -1 et 1, module la fréquence
+        __m128 tri = _mm_sub_ps(_mm_mul_ps(two, _mm_and_ps(abs_mask, _mm_sub_ps(_mm_mul_ps(two, lfo_phase), one))), one);
+        __m128 step = _mm_mul_ps(inc, _mm_add_ps(one, _mm_mul_ps(lfo_depth, tri)));
+        phase = _mm_add_ps(phase, step);
+        phase = _mm_sub_ps(phase, _mm_and_ps(_mm_cmpge_ps(phase, one), one));
+        lfo_phase = _mm_add_ps(lfo_phase, lfo_inc);
+        lfo_phase = _mm_sub_ps(lfo_phase, _mm_and_ps(_mm_cmpge_ps(lfo_phase, one), one));
+        // Voix muette : inc ne glisse plus, sinon il finirait dénormalisé
+        inc = _mm_or_ps(_mm_and_ps(live, _mm_mul_ps(inc, sweep)), _mm_andnot_ps(live, inc));
+
+        // Carré : +1 sur la première moitié de la période, -1 ensuite
+        __m128 square = _mm_sub_ps(one, _mm_and_ps(_mm_cmpge_ps(phase, half), two));
+        lfsr = _mm_xor_si128(lfsr, _mm_slli_epi32(lfsr, 13));
+        lfsr = _mm_xor_si128(lfsr, _mm_srli_epi32(lfsr, 17));
+        lfsr = _mm_xor_si128(lfsr, _mm_slli_epi32(lfsr, 5));
+        __m128 noise = _mm_mul_ps(_mm_cvtepi32_ps(lfsr), to_float);
+
+        __m128 src = _mm_add_ps(square, _mm_mul_ps(noise_mix, _mm_sub_ps(noise, square)));
+        lp = _mm_add_ps(lp, _mm_mul_ps(lp_k, _mm_sub_ps(src, lp)));
+        __m128 out = _mm_mul_ps(lp, amp);
+        amp = _mm_and_ps(_mm_mul_ps(amp, decay), live);
+        acc[i] = first ? out : _mm_add_ps(acc[i], out);
+    }
+    _mm_storeu_ps(v.phase + g, phase);
+    _mm_storeu_ps(v.inc + g, inc);
+    _mm_storeu_ps(v.lfo_phase + g, lfo_phase);
+    _mm_storeu_ps(v.lp + g, lp);
+    _mm_storeu_ps(v.amp + g, amp);
+    _mm_storeu_si128((__m128i *)(v.lfsr + g), lfsr);
+}
+
+static void render_block(int16_t *out, uint32_t n)
+{
+    static __m128 acc[BLOCK];
+    const __m128 gain = _mm_set1_ps(MASTER * 32767.0f);
+    uint32_t i = 0;
+
+    for (int g = 0; g < LANES; g += 4)
+        render_group(g, acc, n, g == 0);
+    // 4 échantillons x 4 voies : transposés, la somme des lignes donne 4 échantillons
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128 a0 = acc[i], a1 = acc[i + 1], a2 = acc[i + 2], a3 = acc[i + 3];
+        __m128 b0 = acc[i + 4], b1 = acc[i + 5], b2 = acc[i + 6], b3 = acc[i + 7];
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+        _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+        __m128 lo = _mm_mul_ps(_mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)), gain);
+        __m128 hi = _mm_mul_ps(_mm_add_ps(_mm_add_ps(b0, b1), _mm_add_ps(b2, b3)), gain);
+        // packs sature en int16, pas besoin de borner à la main
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+    }
+    for (; i < n; i++)
+    {
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc[i]);
+        float s = (lanes[0] + lanes[1] + lanes[2] + lanes[3]) * MASTER * 32767.0f;
+        out[i] = s > 32767.0f ? 32767 : s < -32768.0f ? -32768 : (int16_t)s;
+    }
+}
+#else
+static void render_block(int16_t *out, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float sum = 0;
+        for (int l = 0; l < LANES; l++)
+        {
+            float tri = 2.0f * SDL_fabsf(2.0f * v.lfo_phase[l] - 1.0f) - 1.0f;
+            v.phase[l] += v.inc[l] * (1.0f + v.lfo_depth[l] * tri);
+            if (v.phase[l] >= 1.0f)
+                v.phase[l] -= 1.0f;
+            v.lfo_phase[l] += v.lfo_inc[l];
+            if (v.lfo_phase[l] >= 1.0f)
+                v.lfo_phase[l] -= 1.0f;
+            if (v.amp[l] > SILENCE)
+                v.inc[l] *= v.sweep[l];
+
+            float square = v.phase[l] < 0.5f ? 1.0f : -1.0f;
+            uint32_t x = v.lfsr[l];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            v.lfsr[l] = x;
+            float noise = (int32_t)x * (1.0f / 2147483648.0f);
+
+            float src = square + v.noise[l] * (noise - square);
+            v.lp[l] += v.lp_k[l] * (src - v.lp[l]);
+            sum += v.lp[l] * v.amp[l];
+            v.amp[l] = v.amp[l] > SILENCE ? v.amp[l] * v.decay[l] : 0;
+        }
+        float s = sum * MASTER * 32767.0f;
+        out[i] = s > 32767.0f ? 32767 : s < -32768.0f ? -32768 : (int16_t)s;
+    }
+}
+#endif
+
+void synth_render(int16_t *out, uint32_t n)
+{
+    while (n > 0)
+    {
+        uint32_t len = n < BLOCK ? n : BLOCK;
+        render_block(out, len);
+        out += len;
+        n -= len;
+    }
+}
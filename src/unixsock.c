@@ -0,0 +1,53 @@
+#include "../includes/unixsock.h"
+
+#ifndef _WIN32
+
+# include <string.h>
+# include <unistd.h>
+
+// -1 si le chemin ne tient pas dans sun_path
+int unix_address(const char *path, struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return -1;
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+// Une ligne, sans le '\n'. -1 si la connexion se ferme avant
+int read_line(int fd, char *buf, int size)
+{
+    int len = 0;
+
+    while (len < size - 1)
+    {
+        ssize_t got = read(fd, buf + len, 1);
+        if (got <= 0)
+            return -1;
+        if (buf[len] == '\n')
+            break;
+        len++;
+    }
+    buf[len] = '\0';
+    if (len && buf[len - 1] == '\r')
+        buf[--len] = '\0';
+    return len;
+}
+
+void write_all(int fd, const char *s)
+{
+    size_t left = strlen(s);
+
+    while (left)
+    {
+        ssize_t n = write(fd, s, left);
+        if (n <= 0)
+            return;
+        s += n;
+        left -= n;
+    }
+}
+
+#endif
@@ -0,0 +1,215 @@
+#include "../includes/vecenv.h"
+#include "../includes/pool.h"
+#include "../includes/invaders.h"
+#include "../includes/obs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Environnement vectorisé pour l'apprentissage par renforcement : N machines
+libi8080 indépendantes avancent d'un pas à la fois, une tâche du pool de
+threads par machine. Les résultats vont dans des tableaux contigus (une
+entrée par env) que l'appelant lit sans copie.
+
+Un début de partie (crédit inséré, 1 joueur lancé) est préparé une seule
+fois puis sauvegardé : un reset n'est qu'un chargement d'état. Score et
+vaisseaux sont lus dans la RAM du jeu (invaders.c) ; la partie est finie
+quand le jeu repasse en mode démo.
+*/
+
+static const uint8_t action_bits[NB_ACTIONS] = {
+    [ACT_NOOP]       = 0,
+    [ACT_LEFT]       = I8080_P1_LEFT,
+    [ACT_RIGHT]      = I8080_P1_RIGHT,
+    [ACT_FIRE]       = I8080_P1_SHOT,
+    [ACT_LEFT_FIRE]  = I8080_P1_LEFT | I8080_P1_SHOT,
+    [ACT_RIGHT_FIRE] = I8080_P1_RIGHT | I8080_P1_SHOT,
+};
+
+int parse_vec_obs(const char *name, Vec_Obs *out)
+{
+    if (strcmp(name, "raw") == 0)
+        *out = VEC_OBS_RAW;
+    else if (strcmp(name, "packed") == 0)
+        *out = VEC_OBS_PACKED;
+    else if (strcmp(name, "gray") == 0)
+        *out = VEC_OBS_GRAY;
+    else if (strcmp(name, "pooled") == 0)
+        *out = VEC_OBS_POOLED;
+    else
+        return -1;
+    return 0;
+}
+
+size_t vec_obs_size(Vec_Obs mode)
+{
+    switch (mode)
+    {
+        case VEC_OBS_PACKED:
+            return OBS_PACKED_SIZE;
+        case VEC_OBS_GRAY:
+            return OBS_GRAY_SIZE;
+        case VEC_OBS_POOLED:
+            return VECENV_POOL_W * VECENV_POOL_H;
+        default:
+            return I8080_VRAM_SIZE;
+    }
+}
+
+static void observe(Vec_Env *env, int i)
+{
+    const I8080_Machine *m = env->machines[i];
+    const uint8_t *vram = i8080_get_frame(m);
+    uint8_t *out = env->obs + (size_t)i * env->obs_size;
+
+    switch (env->obs_mode)
+    {
+        case VEC_OBS_PACKED:
+            obs_packed(vram, out);
+            break;
+        case VEC_OBS_GRAY:
+            obs_gray(vram, out);
+            break;
+        case VEC_OBS_POOLED:
+            obs_pooled(vram, out, VECENV_POOL_W, VECENV_POOL_H);
+            break;
+        default:
+            memcpy(out, vram, env->obs_size);
+            break;
+    }
+    env->scores[i] = invaders_score(m);
+    env->lives[i] = invaders_ships(m);
+}
+
+static void reset_env(Vec_Env *env, int i)
+{
+    i8080_load_state(env->machines[i], env->start_state, env->state_size);
+}
+
+// Une tâche du pool : env i avance de frame_skip frames
+static void step_job(void *user, int i)
+{
+    Vec_Env *env = user;
+    I8080_Machine *m = env->machines[i];
+    uint8_t action = env->actions[i] < NB_ACTIONS ? env->actions[i] : ACT_NOOP;
+    uint32_t before = invaders_score(m);
+    bool done = false;
+    int f = 0;
+
+    // Le pas précédent a fini une partie : ses compteurs restaient lisibles jusqu'ici
+    if (env->dones[i])
+        env->episode_frames[i] = 0;
+    i8080_set_inputs(m, action_bits[action], 0);
+    // Une partie finie en cours de pas l'arrête : seules les frames jouées comptent
+    for (; f < env->frame_skip && !done; f++)
+    {
+        i8080_run_frame(m);
+        done = !invaders_playing(m);
+    }
+    env->episode_frames[i] += f;
+    uint32_t score = invaders_score(m);
+    env->rewards[i] = (int32_t)(score - before);
+    env->dones[i] = done;
+    if (done)
+    {
+        // L'observation rendue est celle de la nouvelle partie, score et durée ceux de la finie
+        reset_env(env, i);
+        observe(env, i);
+        env->scores[i] = score;
+        return;
+    }
+    observe(env, i);
+}
+
+Vec_Env *create_vec_env(const char *rom, int nb_envs, int frame_skip, Vec_Obs obs_mode, int nb_threads)
+{
+    if (nb_envs < 1 || nb_envs > VECENV_MAX || frame_skip < 1 || frame_skip > VECENV_MAX_SKIP
+        || obs_mode < VEC_OBS_RAW || obs_mode > VEC_OBS_POOLED)
+        return NULL;
+    Vec_Env *env = calloc(1, sizeof(Vec_Env));
+    if (!env)
+        return NULL;
+    env->nb_envs = nb_envs;
+    env->frame_skip = frame_skip;
+    env->obs_mode = obs_mode;
+    env->obs_size = vec_obs_size(obs_mode);
+    env->state_size = i8080_state_size();
+    env->obs = malloc((size_t)nb_envs * env->obs_size);
+    env->rewards = calloc(nb_envs, sizeof(int32_t));
+    env->dones = calloc(nb_envs, sizeof(uint8_t));
+    env->scores = calloc(nb_envs, sizeof(uint32_t));
+    env->lives = calloc(nb_envs, sizeof(uint8_t));
+    env->episode_frames = calloc(nb_envs, sizeof(uint32_t));
+    env->machines = calloc(nb_envs, sizeof(I8080_Machine *));
+    env->start_state = malloc(env->state_size);
+    if (!env->obs || !env->rewards || !env->dones || !env->scores || !env->lives
+        || !env->episode_frames || !env->machines || !env->start_state)
+    {
+        destroy_vec_env(env);
+        return NULL;
+    }
+    for (int i = 0; i < nb_envs; i++)
+    {
+        env->machines[i] = i8080_create();
+        if (!env->machines[i] || i8080_load_rom(env->machines[i], rom) != 0)
+        {
+            destroy_vec_env(env);
+            return NULL;
+        }
+    }
+    if (invaders_start_game(env->machines[0]) != 0)
+    {
+        printf("ERR: the game did not start, is %s a Space Invaders ROM?\n", rom);
+        destroy_vec_env(env);
+        return NULL;
+    }
+    i8080_save_state(env->machines[0], env->start_state, env->state_size);
+    if (init_pool(nb_threads) != 0)
+    {
+        destroy_vec_env(env);
+        return NULL;
+    }
+    vec_env_reset(env);
+    return env;
+}
+
+void vec_env_reset(Vec_Env *env)
+{
+    for (int i = 0; i < env->nb_envs; i++)
+    {
+        reset_env(env, i);
+        observe(env, i);
+        env->rewards[i] = 0;
+        env->dones[i] = 0;
+        env->episode_frames[i] = 0;
+    }
+}
+
+// actions : nb_envs valeurs de Vec_Action. Les env finis repartent d'eux-mêmes
+void vec_env_step(Vec_Env *env, const uint8_t *actions)
+{
+    env->actions = actions;
+    pool_run(step_job, env, env->nb_envs);
+    env->actions = NULL;
+    for (int i = 0; i < env->nb_envs; i++)
+        env->episodes += env->dones[i];
+}
+
+void destroy_vec_env(Vec_Env *env)
+{
+    if (!env)
+        return;
+    for (int i = 0; env->machines && i < env->nb_envs; i++)
+        i8080_destroy(env->machines[i]);
+    free(env->machines);
+    free(env->obs);
+    free(env->rewards);
+    free(env->dones);
+    free(env->scores);
+    free(env->lives);
+    free(env->episode_frames);
+    free(env->start_state);
+    free(env);
+}
@@ -1,10 +1,24 @@
 #include <stdio.h>
 
 #include "../includes/video.h"
+#include "../includes/memory.h"
+#include "../includes/overlay.h"
+#include "../includes/filter.h"
+#include "../includes/pool.h"
 
 static SDL_Window *win = NULL;
 static SDL_Renderer *ren = NULL;
 static SDL_Texture *ptex = NULL;
+static uint32_t filter_src[W * H]; // Image avant post-traitement
+static bool vram_uploaded = false;  // La texture contient la dernière VRAM affichée
+static bool vsync = true;
+
+// Texture native (VRAM non tournée, 256x224) quand le renderer sait l'afficher
+static SDL_Texture *ntex = NULL;
+static Upload_Mode upload_mode = UPLOAD_ARGB;
+#if SDL_VERSION_ATLEAST(3, 4, 0)
+static SDL_Palette *npal = NULL;
+#endif
 
 
 void draw_test_checker(uint32_t* framebuffer)
@@ -20,6 +34,46 @@ void draw_test_checker(uint32_t* framebuffer)
     draw_pixels(framebuffer);
 }
 
+// Essaie de créer une texture indexée dans l'orientation de la VRAM (NATIVE_W x NATIVE_H).
+// Les textures palettisées n'existent qu'à partir de SDL 3.4, sinon on reste en ARGB.
+static void init_native_texture()
+{
+#if SDL_VERSION_ATLEAST(3, 4, 0)
+    static const SDL_PixelFormat formats[] = { SDL_PIXELFORMAT_INDEX1LSB, SDL_PIXELFORMAT_INDEX8 };
+    static const Upload_Mode modes[] = { UPLOAD_INDEX1, UPLOAD_INDEX8 };
+    SDL_Color colors[2] = { {0, 0, 0, 255}, {255, 255, 255, 255} };
+
+    npal = SDL_CreatePalette(2);
+    if (!npal || !SDL_SetPaletteColors(npal, colors, 0, 2))
+        return;
+    for (int i = 0; i < 2; i++)
+    {
+        ntex = SDL_CreateTexture(ren, formats[i], SDL_TEXTUREACCESS_STREAMING, NATIVE_W, NATIVE_H);
+        if (ntex && SDL_SetTexturePalette(ntex, npal))
+        {
+            upload_mode = modes[i];
+            return;
+        }
+        SDL_DestroyTexture(ntex);
+        ntex = NULL;
+    }
+#endif
+}
+
+// La vsync est coupée quand le pacer rythme lui-même, et pendant le turbo
+void set_vsync(bool enabled)
+{
+    vsync = enabled;
+    if (ren)
+        SDL_SetRenderVSync(ren, vsync ? 1 : 0);
+}
+
+void set_window_title(const char *title)
+{
+    if (win)
+        SDL_SetWindowTitle(win, title);
+}
+
 int init_sdl()
 {
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
@@ -27,7 +81,7 @@ int init_sdl()
         return 1;
     }
 
-    win = SDL_CreateWindow("Intel8080 - SpaceInvader", W, H, 0);
+    win = SDL_CreateWindow(WINDOW_TITLE, W * get_filter_scale(), H * get_filter_scale(), 0);
     if (!win) {
         SDL_Log("CreateWindow: %s", SDL_GetError());
         SDL_Quit();
@@ -41,7 +95,12 @@ int init_sdl()
         SDL_Quit();
         return 1;
     }
-    SDL_SetRenderVSync(ren, 1);
+    SDL_SetRenderVSync(ren, vsync ? 1 : 0);
+
+    // Les filtres travaillent sur les pixels ARGB, pas de texture native avec eux
+    if (get_filter() == FILTER_NONE)
+        init_native_texture();
+    SDL_Log("Video upload: %s", upload_mode == UPLOAD_INDEX1 ? "1bpp" : upload_mode == UPLOAD_INDEX8 ? "8bpp" : "ARGB8888");
     /*int running = 1;
     while (running) {
         // 1) événements
@@ -56,28 +115,222 @@ int init_sdl()
 
 void SDL_exit()
 {
+    if (ntex)
+        SDL_DestroyTexture(ntex);
+#if SDL_VERSION_ATLEAST(3, 4, 0)
+    if (npal)
+        SDL_DestroyPalette(npal);
+#endif
+    if (ptex)
+        SDL_DestroyTexture(ptex);
+    quit_pool();
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     SDL_Quit();
 }
 
+Upload_Mode get_upload_mode()
+{
+    return upload_mode;
+}
+
+// Convertit la VRAM (1 bit par pixel, écran tourné de 90°) en ARGB8888 W x H.
+// pitch est en pixels, ce qui permet d'écrire directement dans une texture verrouillée.
+// La couleur des pixels allumés vient de l'overlay, ligne par ligne, dans la même passe.
+void fill_frame_buffer(const uint8_t *vram, uint32_t *frameBuffer, int pitch)
+{
+    const uint32_t *rows = get_overlay_rows();
+
+    // Space Invaders utilise 224x256 (WxH)
+    // La VRAM commence à 0x2400, chaque colonne de l'écran fait 32 octets
+    for (int x = 0; x < W; x++)
+    {
+        const uint8_t *column = vram + x * 32;
+        // Le bit 0 du premier octet est le pixel tout en bas de la colonne
+        uint32_t *px = frameBuffer + (H - 1) * pitch + x;
+        int y = H - 1;
+
+        for (int i = 0; i < 32; i++)
+        {
+            uint8_t current_byte = column[i];
+            for (int bit = 0; bit < 8; bit++)
+            {
+                // Si le bit est à 1, couleur de la ligne, sinon noir
+                *px = ((current_byte >> bit) & 1) ? rows[y] : 0xFF000000u;
+                px -= pitch;
+                y--;
+            }
+        }
+    }
+}
+
+// Le rectangle de destination d'une texture native : une fois tournée de 270°
+// autour de son centre elle doit recouvrir toute la sortie du renderer
+static SDL_FRect native_dst_rect()
+{
+    int ow = W;
+    int oh = H;
+    SDL_GetCurrentRenderOutputSize(ren, &ow, &oh);
+    SDL_FRect dst = { (ow - oh) / 2.0f, (oh - ow) / 2.0f, (float)oh, (float)ow };
+    return dst;
+}
+
+// Dessine la texture native, une bande d'overlay à la fois avec un color mod :
+// la palette reste noir/blanc et la couleur est appliquée par le GPU
+static void render_native()
+{
+    SDL_FRect dst = native_dst_rect();
+    const Overlay_Band *bands;
+    int nb_bands;
+
+    if (overlay_is_mono())
+    {
+        SDL_SetTextureColorMod(ntex, 255, 255, 255);
+        SDL_RenderTextureRotated(ren, ntex, NULL, &dst, 270.0, NULL, SDL_FLIP_NONE);
+        return;
+    }
+
+    // Une bande de lignes écran [first, last] correspond à des colonnes de la texture native
+    float sy = dst.w / H;
+    float ow = dst.h;
+    nb_bands = get_overlay_bands(&bands);
+    for (int i = 0; i < nb_bands; i++)
+    {
+        float bh = (bands[i].last - bands[i].first + 1) * sy;
+        float cy = bands[i].first * sy + bh / 2.0f;
+        SDL_FRect src = { (float)(NATIVE_W - 1 - bands[i].last), 0, (float)(bands[i].last - bands[i].first + 1), NATIVE_H };
+        SDL_FRect band_dst = { ow / 2.0f - bh / 2.0f, cy - ow / 2.0f, bh, ow };
+
+        SDL_SetTextureColorMod(ntex, (bands[i].color >> 16) & 0xFF, (bands[i].color >> 8) & 0xFF, bands[i].color & 0xFF);
+        SDL_RenderTextureRotated(ren, ntex, &src, &band_dst, 270.0, NULL, SDL_FLIP_NONE);
+    }
+}
+
+static bool upload_native(const uint8_t *vram)
+{
+    if (upload_mode == UPLOAD_INDEX1)
+        return SDL_UpdateTexture(ntex, NULL, vram, NATIVE_W / 8); // 7 Ko envoyés tels quels
+
+    // UPLOAD_INDEX8 : un octet par pixel, mais sans rotation ni couleur côté CPU
+    void *pixels;
+    int pitch;
+    if (!SDL_LockTexture(ntex, NULL, &pixels, &pitch))
+        return false;
+    for (int y = 0; y < NATIVE_H; y++)
+    {
+        uint8_t *row = (uint8_t *)pixels + y * pitch;
+        const uint8_t *src = vram + y * (NATIVE_W / 8);
+        for (int i = 0; i < NATIVE_W / 8; i++)
+            for (int bit = 0; bit < 8; bit++)
+                *row++ = (src[i] >> bit) & 1;
+    }
+    SDL_UnlockTexture(ntex);
+    return true;
+}
+
+// Affiche directement la VRAM : texture indexée tournée par le GPU si possible,
+// sinon expansion ARGB sur le CPU dans une texture streaming (pas de copie intermédiaire)
+void draw_vram(const uint8_t *vram)
+{
+    if (ntex)
+    {
+        if (upload_native(vram))
+        {
+            SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+            SDL_RenderClear(ren);
+            render_native();
+            SDL_RenderPresent(ren);
+            vram_uploaded = true;
+            return;
+        }
+        // Le renderer a refusé l'upload : on repasse définitivement en ARGB
+        SDL_Log("UpdateTexture (native): %s", SDL_GetError());
+        SDL_DestroyTexture(ntex);
+        ntex = NULL;
+        upload_mode = UPLOAD_ARGB;
+    }
+
+    if (!ptex) {
+        ptex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                 W * get_filter_scale(), H * get_filter_scale());
+        if (!ptex) {
+            SDL_Log("CreateTexture: %s", SDL_GetError());
+            return;
+        }
+    }
+
+    void *pixels;
+    int pitch;
+    if (!SDL_LockTexture(ptex, NULL, &pixels, &pitch)) {
+        SDL_Log("LockTexture: %s", SDL_GetError());
+        return;
+    }
+    if (get_filter() == FILTER_NONE)
+        fill_frame_buffer(vram, (uint32_t *)pixels, pitch / 4);
+    else
+    {
+        // Conversion -> filtre (multithread) -> texture
+        fill_frame_buffer(vram, filter_src, W);
+        apply_filter(filter_src, (uint32_t *)pixels, pitch / 4);
+    }
+    SDL_UnlockTexture(ptex);
+    vram_uploaded = true;
+
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+    SDL_RenderClear(ren);
+    SDL_RenderTexture(ren, ptex, NULL, NULL);
+    SDL_RenderPresent(ren);
+}
+
+// Frame identique à la précédente : la texture est déjà à jour, on la réaffiche
+// seulement (le present garde le rythme de la vsync)
+static void redraw()
+{
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+    SDL_RenderClear(ren);
+    if (ntex)
+        render_native();
+    else
+        SDL_RenderTexture(ren, ptex, NULL, NULL);
+    SDL_RenderPresent(ren);
+}
 
 // W et H sont les dimensions logiques de l’image, p.ex. 224x256
 // framebuffer est un tableau W*H en ARGB8888 (uint32_t par pixel)
 void draw_pixels(const uint32_t* framebuffer)
 {
+    int scale = get_filter_scale();
+
+    vram_uploaded = false;
+
     // Créer la texture une fois si besoin
     if (!ptex) {
         ptex = SDL_CreateTexture(ren,
                                   SDL_PIXELFORMAT_ARGB8888,
-                                  SDL_TEXTUREACCESS_STATIC, // ou STREAMING
-                                  W, H);
+                                  SDL_TEXTUREACCESS_STREAMING,
+                                  W * scale, H * scale);
         if (!ptex) {
             SDL_Log("CreateTexture: %s", SDL_GetError());
             return;
         }
     }
 
+    if (get_filter() != FILTER_NONE) {
+        void *pixels;
+        int pitch;
+        if (!SDL_LockTexture(ptex, NULL, &pixels, &pitch)) {
+            SDL_Log("LockTexture: %s", SDL_GetError());
+            return;
+        }
+        apply_filter(framebuffer, (uint32_t *)pixels, pitch / 4);
+        SDL_UnlockTexture(ptex);
+        SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+        SDL_RenderClear(ren);
+        SDL_RenderTexture(ren, ptex, NULL, NULL);
+        SDL_RenderPresent(ren);
+        return;
+    }
+
     // Met à jour toute la texture depuis le framebuffer (copie interne SDL)
     int pitch = W * 4; // octets par ligne dans framebuffer car 32bits = 4octets donc 1 pixel vaut 4 octets
     if (SDL_UpdateTexture(ptex, NULL, framebuffer, pitch)) {
@@ -94,4 +347,15 @@ void draw_pixels(const uint32_t* framebuffer)
 void print_version_sdl3()
 {
     printf("%d", SDL_GetVersion());
-}
\ No newline at end of file
+}
+
+static void sdl_present(const Frame *frame)
+{
+    if (!frame->changed && vram_uploaded)
+        redraw();
+    else
+        draw_vram(frame->vram);
+}
+
+// Fenêtre + renderer SDL, le seul backend qui initialise la vidéo SDL
+const Video_Backend sdl_backend = { "sdl", true, init_sdl, sdl_present, SDL_exit };
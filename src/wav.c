@@ -0,0 +1,211 @@
+#include "../includes/wav.h"
+#include "../includes/cpu8080.h"
+#include "../includes/ring.h"
+#include "../includes/sound.h"
+#include "../includes/utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+Capture du son mixé dans un fichier WAV (PCM 16 bits mono). Comme pour
+l'enregistreur de frames, le thread de l'émulation ne fait que copier les
+échantillons dans une file sans verrou ; un thread d'écriture la vide sur le
+disque. Un échantillon perdu décalerait tout le reste : file pleine,
+l'émulation attend toujours.
+
+Le fichier porte un chunk "bext" (Broadcast Wave) dont le TimeReference est
+l'indice du premier échantillon sur l'horloge émulée. L'échantillon n tombe
+au cycle n * CPU_CLOCK / SOUND_RATE : avec le cycle des frames vidéo, les
+deux flux se recalent sans dérive.
+*/
+
+#define QUEUE_BYTES (SOUND_RATE * 2 * sizeof(int16_t)) // ~2 s
+#define WRITE_CHUNK 4096
+#define BEXT_SIZE 602
+#define BEXT_TIME_REF 338 // Offset de TimeReferenceLow dans le chunk
+
+static Ring queue;
+static SDL_Thread *writer = NULL;
+static SDL_Semaphore *data_sem = NULL;
+static SDL_Semaphore *space_sem = NULL;
+static SDL_AtomicInt stopping;
+static FILE *out = NULL;
+static long data_offset;
+static uint64_t start;
+static uint64_t nb_written = 0; // Lu par le thread principal seulement après SDL_WaitThread
+static uint32_t max_depth = 0;
+static uint32_t stalls = 0;
+
+static void write_header()
+{
+    uint8_t riff[12] = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E' };
+    uint8_t fmt[8 + 16] = { 'f', 'm', 't', ' ' };
+    static uint8_t bext[8 + BEXT_SIZE];
+    uint8_t data[8] = { 'd', 'a', 't', 'a' };
+
+    put_le32(fmt + 4, 16);
+    put_le16(fmt + 8, 1); // PCM
+    put_le16(fmt + 10, 1);
+    put_le32(fmt + 12, SOUND_RATE);
+    put_le32(fmt + 16, SOUND_RATE * sizeof(int16_t));
+    put_le16(fmt + 20, sizeof(int16_t));
+    put_le16(fmt + 22, 16);
+
+    memset(bext, 0, sizeof(bext));
+    memcpy(bext, "bext", 4);
+    put_le32(bext + 4, BEXT_SIZE);
+    snprintf((char *)bext + 8, 256, "Space Invaders, first sample at emulated cycle %llu",
+        (unsigned long long)(start * CPU_CLOCK / SOUND_RATE));
+    put_le32(bext + 8 + BEXT_TIME_REF, (uint32_t)start);
+    put_le32(bext + 8 + BEXT_TIME_REF + 4, (uint32_t)(start >> 32));
+    put_le16(bext + 8 + BEXT_TIME_REF + 8, 1); // Version
+
+    fwrite(riff, 1, sizeof(riff), out);
+    fwrite(fmt, 1, sizeof(fmt), out);
+    fwrite(bext, 1, sizeof(bext), out);
+    fwrite(data, 1, sizeof(data), out);
+    data_offset = ftell(out);
+}
+
+// Tailles RIFF et data, inconnues tant que la capture tourne
+static void patch_header()
+{
+    uint8_t size[4];
+    long end = ftell(out);
+
+    put_le32(size, (uint32_t)(end - 8));
+    fseek(out, 4, SEEK_SET);
+    fwrite(size, 1, 4, out);
+    put_le32(size, (uint32_t)(end - data_offset));
+    fseek(out, data_offset - 4, SEEK_SET);
+    fwrite(size, 1, 4, out);
+}
+
+static int writer_thread(void *data)
+{
+    static uint8_t buf[WRITE_CHUNK];
+    (void)data;
+
+    while (1)
+    {
+        SDL_WaitSemaphoreTimeout(data_sem, 100);
+        uint32_t got;
+        while ((got = ring_read(&queue, buf, sizeof(buf))) > 0)
+        {
+            SDL_SignalSemaphore(space_sem);
+            fwrite(buf, 1, got, out);
+            nb_written += got / sizeof(int16_t);
+        }
+        if (SDL_GetAtomicInt(&stopping) && ring_used(&queue) == 0)
+            break;
+    }
+    return 0;
+}
+
+// Arrête le thread d'écriture (après la file) et libère tout ce qui a été ouvert.
+// patch: le fichier est complet, sa taille est reportée dans l'en-tête
+static void release_wav(bool patch)
+{
+    if (writer)
+    {
+        SDL_SetAtomicInt(&stopping, 1);
+        SDL_SignalSemaphore(data_sem);
+        SDL_WaitThread(writer, NULL);
+        writer = NULL;
+    }
+    if (out && patch)
+        patch_header();
+    if (out)
+        fclose(out);
+    out = NULL;
+    free_ring(&queue);
+    if (data_sem)
+        SDL_DestroySemaphore(data_sem);
+    if (space_sem)
+        SDL_DestroySemaphore(space_sem);
+    data_sem = NULL;
+    space_sem = NULL;
+}
+
+// start_sample: indice, sur l'horloge émulée, du premier échantillon qui sera poussé
+int start_wav_capture(const char *path, uint64_t start_sample)
+{
+    if (writer)
+        return -1;
+    out = fopen(path, "wb");
+    if (!out)
+    {
+        perror("Error fopen wav:");
+        return -1;
+    }
+    start = start_sample;
+    write_header();
+    data_sem = SDL_CreateSemaphore(0);
+    space_sem = SDL_CreateSemaphore(0);
+    SDL_SetAtomicInt(&stopping, 0);
+    nb_written = 0;
+    max_depth = 0;
+    stalls = 0;
+    if (init_ring(&queue, QUEUE_BYTES) != 0 || !data_sem || !space_sem)
+    {
+        release_wav(false);
+        remove(path);
+        return -1;
+    }
+    writer = SDL_CreateThread(writer_thread, "wav", NULL);
+    if (!writer)
+    {
+        SDL_Log("CreateThread: %s", SDL_GetError());
+        release_wav(false);
+        remove(path);
+        return -1;
+    }
+    return 0;
+}
+
+bool wav_capture_active()
+{
+    return writer != NULL;
+}
+
+// Thread de l'émulation : tout est écrit, quitte à attendre de la place
+void wav_capture_push(const int16_t *samples, uint32_t n)
+{
+    const uint8_t *p = (const uint8_t *)samples;
+    uint32_t len = n * sizeof(int16_t);
+
+    if (!writer)
+        return;
+    while (1)
+    {
+        uint32_t done = ring_write(&queue, p, len);
+        p += done;
+        len -= done;
+        if (!len)
+            break;
+        stalls++;
+        SDL_SignalSemaphore(data_sem);
+        SDL_WaitSemaphoreTimeout(space_sem, 10);
+    }
+    SDL_SignalSemaphore(data_sem);
+
+    uint32_t depth = ring_used(&queue) / sizeof(int16_t);
+    if (depth > max_depth)
+        max_depth = depth;
+}
+
+void stop_wav_capture()
+{
+    if (!writer)
+        return;
+    release_wav(true);
+}
+
+void get_wav_stats(Wav_Stats *stats)
+{
+    stats->start_sample = start;
+    stats->samples = writer ? 0 : nb_written;
+    stats->max_depth = max_depth;
+    stats->stalls = stalls;
+}